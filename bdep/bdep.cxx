@@ -12,6 +12,7 @@
 #include <bdep/types.hxx>
 #include <bdep/utility.hxx>
 
+#include <bdep/stat.hxx>
 #include <bdep/project.hxx>         // find_project()
 #include <bdep/diagnostics.hxx>
 #include <bdep/bdep-options.hxx>
@@ -34,6 +35,7 @@
 #include <bdep/test.hxx>
 #include <bdep/update.hxx>
 #include <bdep/clean.hxx>
+#include <bdep/foreach.hxx>
 
 using namespace std;
 using namespace butl;
@@ -144,6 +146,11 @@ init (const common_options& co,
     ? o.verbose ()
     : o.V () ? 3 : o.v () ? 2 : o.quiet () ? 0 : 1;
 
+  // Execution statistics.
+  //
+  stat_enabled = o.stat ();
+  trace_init (o.trace_file ()); // Empty if not specified.
+
   // Temporary directory.
   //
   if (tmp)
@@ -198,6 +205,10 @@ try
          << system_error (errno, generic_category ()); // Sanitize.
 #endif
 
+  // Note that this should be done before we open any files.
+  //
+  jobserver_init ();
+
   argv_file_scanner argv_scan (argc, argv, "--options-file");
   group_scanner scan (argv_scan);
 
@@ -309,6 +320,7 @@ try
     COMMAND_IMPL (test,    test,    "test",    true);
     COMMAND_IMPL (update,  update,  "update",  true);
     COMMAND_IMPL (clean,   clean,   "clean",   true);
+    COMMAND_IMPL (foreach, foreach, "foreach", true);
 
     assert (false);
     fail << "unhandled command";
@@ -321,6 +333,9 @@ try
 
   clean_tmp (true /* ignore_error */);
 
+  if (stat_enabled)
+    stat_print ();
+
   if (r != 0)
     return r;
 
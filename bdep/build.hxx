@@ -8,10 +8,22 @@
 #include <bdep/types.hxx>
 #include <bdep/utility.hxx>
 
+#include <bdep/project.hxx> // package_name
+
 namespace bdep
 {
   // Common "build system command" (update, clean, test) implementation.
   //
+  // If the package filter is specified, then it is called once with the
+  // project directory and the returned predicate is used to weed out
+  // packages that should not be built.
+  //
+  using package_filter =
+    function<function<bool (const package_name&)> (const dir_path& prj)>;
+
+  // If reverse_waves is true, then the dependency-ordered waves (--waves)
+  // are built in the reverse order, that is, dependents first.
+  //
   template <typename O>
   int
   cmd_build (const O& o,
@@ -19,7 +31,9 @@ namespace bdep
                             const shared_ptr<configuration>&,
                             const cstrings&,
                             const strings&),
-             cli::scanner& args);
+             cli::scanner& args,
+             const package_filter& = nullptr,
+             bool reverse_waves = false);
 }
 
 #include <bdep/build.txx>
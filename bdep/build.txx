@@ -19,7 +19,9 @@ namespace bdep
                             const shared_ptr<configuration>&,
                             const cstrings&,
                             const strings&),
-             cli::scanner& args)
+             cli::scanner& args,
+             const package_filter& pf,
+             bool reverse_waves)
   {
     tracer trace ("build");
 
@@ -56,6 +58,24 @@ namespace bdep
     if (!pp.packages.empty ())
       verify_project_packages (pp, cfgs);
 
+    function<bool (const package_name&)> filter;
+    if (pf)
+      filter = pf (prj);
+
+    // If requested, split the packages into dependency-ordered waves.
+    //
+    package_graph graph;
+    vector<vector<size_t>> waves;
+
+    if (o.waves ())
+    {
+      graph = load_package_graph (prj);
+      waves = graph.waves ();
+
+      if (reverse_waves)
+        reverse (waves.begin (), waves.end ());
+    }
+
     // If no packages were explicitly specified, then we build all that have
     // been initialized in each configuration.
     //
@@ -88,7 +108,29 @@ namespace bdep
         pkgs.clear ();
 
         for (const package_state& p: c->packages)
-          pkgs.push_back (p.name.string ().c_str ());
+        {
+          if (!filter || filter (p.name))
+            pkgs.push_back (p.name.string ().c_str ());
+        }
+      }
+      else if (filter)
+      {
+        pkgs.clear ();
+
+        for (const package_location& p: pp.packages)
+        {
+          if (filter (p.name))
+            pkgs.push_back (p.name.string ().c_str ());
+        }
+      }
+
+      if (pkgs.empty ())
+      {
+        if (verb)
+          info << "skipping configuration " << *c << " with no affected "
+               << "packages";
+
+        continue;
       }
 
       // If we are printing multiple configurations, separate them with a
@@ -107,7 +149,29 @@ namespace bdep
       //
       cmd_sync (o, prj, c, strings () /* pkg_args */, true /* implicit */);
 
-      build (o, c, pkgs, cfg_vars);
+      if (!o.waves ())
+      {
+        build (o, c, pkgs, cfg_vars);
+        continue;
+      }
+
+      for (const vector<size_t>& w: waves)
+      {
+        cstrings ps;
+
+        for (size_t i: w)
+        {
+          const string& n (graph.packages[i].name.string ());
+
+          if (find_if (pkgs.begin (),
+                       pkgs.end (),
+                       [&n] (const char* p) {return n == p;}) != pkgs.end ())
+            ps.push_back (n.c_str ());
+        }
+
+        if (!ps.empty ())
+          build (o, c, ps, cfg_vars);
+      }
     }
 
     return 0;
@@ -33,7 +33,13 @@ namespace bdep
   inline int
   cmd_clean (const cmd_clean_options& o, cli::scanner& args)
   {
-    return cmd_build (o, &cmd_clean, args);
+    // Clean the dependents before their dependencies.
+    //
+    return cmd_build (o,
+                      &cmd_clean,
+                      args,
+                      nullptr /* package_filter */,
+                      true    /* reverse_waves  */);
   }
 }
 
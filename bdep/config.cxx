@@ -4,13 +4,18 @@
 
 #include <bdep/config.hxx>
 
+#include <cstring>  // strchr()
 #include <iostream> // cout
 
 #include <bdep/database.hxx>
 #include <bdep/project-odb.hxx>
 #include <bdep/diagnostics.hxx>
 
+#include <bdep/sync.hxx>
+#include <bdep/test.hxx>
+
 using namespace std;
+using namespace butl;
 
 namespace bdep
 {
@@ -133,15 +138,17 @@ namespace bdep
     }
   }
 
-  shared_ptr<configuration>
-  cmd_config_add (const configuration_add_options& ao,
-                  const dir_path&                  prj,
-                  const package_locations&         pkgs,
-                  database&                        db,
-                  dir_path                         path,
-                  optional<string>                 name,
-                  optional<uint64_t>               id,
-                  const char*                      what)
+  // Add the configuration to the project database. Should be called inside
+  // a transaction.
+  //
+  static shared_ptr<configuration>
+  add_configuration (const configuration_add_options& ao,
+                     const dir_path&                  prj,
+                     const package_locations&         pkgs,
+                     database&                        db,
+                     dir_path                         path,
+                     optional<string>                 name,
+                     optional<uint64_t>               id)
   {
     translate_path_name (prj, path, name);
 
@@ -162,8 +169,6 @@ namespace bdep
     optional<dir_path> rel_path;
     try {rel_path = path.relative (prj);} catch (const invalid_path&) {}
 
-    transaction t (db.begin ());
-
     using count = configuration_count;
 
     optional<bool> def, fwd;
@@ -241,6 +246,24 @@ namespace bdep
       throw;
     }
 
+    return r;
+  }
+
+  shared_ptr<configuration>
+  cmd_config_add (const configuration_add_options& ao,
+                  const dir_path&                  prj,
+                  const package_locations&         pkgs,
+                  database&                        db,
+                  dir_path                         path,
+                  optional<string>                 name,
+                  optional<uint64_t>               id,
+                  const char*                      what)
+  {
+    transaction t (db.begin ());
+
+    shared_ptr<configuration> r (
+      add_configuration (ao, prj, pkgs, db, move (path), move (name), id));
+
     t.commit ();
 
     if (verb)
@@ -298,6 +321,110 @@ namespace bdep
                            "created");
   }
 
+  configurations
+  cmd_config_create_matrix (const common_options&            co,
+                            const configuration_add_options& ao,
+                            const dir_path&                  prj,
+                            const package_locations&         pkgs,
+                            database&                        db,
+                            vector<pair<dir_path, strings>>  cfgs)
+  {
+    // Similar logic to *_create() except that all the configurations are
+    // created in parallel and then added in a single transaction.
+    //
+    // Note that we must detect duplicate directories (including those
+    // derived from names) before creating anything since otherwise several
+    // jobs would be creating the same configuration concurrently.
+    //
+    vector<optional<string>> names;
+
+    for (size_t i (0); i != cfgs.size (); ++i)
+    {
+      dir_path& path (cfgs[i].first);
+      optional<string> name;
+
+      translate_path_name (prj, path, name);
+
+      path.complete ();
+      path.normalize ();
+
+      verify_configuration_path (path, prj, pkgs);
+
+      for (size_t j (0); j != i; ++j)
+      {
+        const optional<string>& n (names[j]);
+
+        if (name && n && *name == *n)
+          fail << "configuration name '" << *name << "' specified multiple "
+               << "times";
+
+        if (cfgs[j].first == path)
+          fail << "configuration directory " << path << " specified "
+               << "multiple times";
+      }
+
+      names.push_back (move (name));
+    }
+
+    size_t n (cfgs.size ());
+
+    // Remove the configuration directories that we create if anything goes
+    // wrong before the configurations are added. Note that since the
+    // creation is stopped on the first failure, only some of them may have
+    // been created. Note also that we leave the pre-existing directories
+    // alone (they could have been wiped by bpkg but they were not ours to
+    // begin with).
+    //
+    vector<auto_rmdir> rms;
+    for (const pair<dir_path, strings>& c: cfgs)
+      rms.push_back (exists (c.first) ? auto_rmdir () : auto_rmdir (c.first));
+
+    parallel_for (n,
+                  parallel_jobs (co),
+                  [&co, &ao, &cfgs] (size_t i)
+                  {
+                    run_bpkg (2,
+                              co,
+                              "create",
+                              "-d", cfgs[i].first,
+                              (ao.wipe () ? "--wipe" : nullptr),
+                              cfgs[i].second);
+                  });
+
+    configurations r;
+
+    transaction t (db.begin ());
+
+    for (size_t i (0); i != n; ++i)
+    {
+      r.push_back (
+        add_configuration (ao,
+                           prj,
+                           package_locations {}, // Already verified.
+                           db,
+                           move (cfgs[i].first),
+                           move (names[i]),
+                           nullopt /* id */));
+    }
+
+    t.commit ();
+
+    for (auto_rmdir& rm: rms)
+      rm.cancel ();
+
+    if (verb)
+    {
+      for (const shared_ptr<configuration>& c: r)
+      {
+        diag_record dr (text);
+        dr << "created configuration ";
+        print_configuration (dr, c);
+      }
+    }
+
+    return r;
+  }
+
   static int
   cmd_config_add (const cmd_config_options& o, cli::scanner& args)
   {
@@ -529,6 +656,385 @@ namespace bdep
     return 0;
   }
 
+  static int
+  cmd_config_relocate (const cmd_config_options& o, cli::scanner&)
+  {
+    tracer trace ("config_relocate");
+
+    dir_path prj (find_project (o));
+    database db (open (prj, trace));
+
+    session ses;
+    transaction t (db.begin ());
+
+    configurations cfgs (
+      find_configurations (o,
+                           prj,
+                           t,
+                           false /* fallback_default */,
+                           false /* validate         */));
+
+    // Derive the new configuration directories from their paths relative to
+    // the project directory. Verify everything before changing anything.
+    //
+    struct relocation
+    {
+      shared_ptr<configuration> config;
+      dir_path                  old_path;
+    };
+    vector<relocation> rs;
+
+    for (const shared_ptr<configuration>& c: cfgs)
+    {
+      if (!c->relative_path)
+        fail << "configuration " << *c << " directory is not relative to "
+             << "project directory " << prj <<
+          info << "use config move to assign it a new directory";
+
+      dir_path path (prj / *c->relative_path);
+      path.normalize ();
+
+      if (path == c->path)
+      {
+        if (verb)
+          info << "configuration " << *c << " is already in " << path;
+
+        continue;
+      }
+
+      if (!exists (path))
+        fail << "configuration directory " << path << " does not exist" <<
+          info << "configuration " << *c << " was expected to be moved "
+               << "together with the project";
+
+      using query = bdep::query<configuration>;
+
+      if (auto p = db.query_one<configuration> (query::path == path.string ()))
+        fail << "configuration " << *p << " already uses directory " << path;
+
+      rs.push_back (relocation {c, c->path});
+      c->path = move (path);
+    }
+
+    // Now replace the project repository in each non-empty bpkg
+    // configuration. The old project location is the repository directory
+    // relative to which the old configuration directory has the same
+    // relative path.
+    //
+    // Note that we do this before committing the database so that if we
+    // fail half way through, re-running relocate will finish the job: for
+    // the configurations that have already been handled the old location
+    // is no longer among the repositories and adding the project repository
+    // again is a noop.
+    //
+    for (const relocation& r: rs)
+    {
+      const shared_ptr<configuration>& c (r.config);
+
+      if (c->packages.empty ())
+        continue;
+
+      optional<dir_path> old_prj;
+      for (dir_path& d: configuration_projects (o,
+                                                c->path,
+                                                prj,
+                                                false /* existing */))
+      {
+        dir_path p (d / *c->relative_path);
+        p.normalize ();
+
+        if (p == r.old_path)
+        {
+          old_prj = move (d);
+          break;
+        }
+      }
+
+      run_bpkg (3,
+                o,
+                "add",
+                "-d", c->path,
+                "--type", "dir",
+                prj);
+
+      if (old_prj)
+        run_bpkg (3,
+                  o,
+                  "remove",
+                  "-d", c->path,
+                  "dir:" + old_prj->string ());
+    }
+
+    for (const relocation& r: rs)
+      db.update (r.config);
+
+    t.commit ();
+
+    // Finally, synchronize the relocated configurations. Note that since we
+    // synchronize with --keep-out, the project packages are reconfigured in
+    // place (that is, their output directories are preserved). Note also
+    // that if we fail half way through, then the database and the bpkg
+    // configurations are already up to date and re-running sync will finish
+    // the job.
+    //
+    for (const relocation& r: rs)
+    {
+      const shared_ptr<configuration>& c (r.config);
+
+      if (verb)
+      {
+        diag_record dr (text);
+        dr << "relocated configuration ";
+        print_configuration (dr, c, false /* flags */);
+        dr << " from " << r.old_path;
+      }
+
+      if (c->packages.empty ())
+        continue;
+
+      cmd_sync (o, prj, c, strings () /* pkg_args */, false /* implicit */);
+    }
+
+    return 0;
+  }
+
+  // Recursively copy the bpkg configuration directory preserving the file
+  // timestamps but omitting the bdep state that is specific to the
+  // configuration (synchronization stamp and lock, cached test results).
+  // Note that symlinks are copied as their targets.
+  //
+  static void
+  copy_configuration (const dir_path& src,
+                      const dir_path& dst,
+                      const dir_path& d = dir_path ())
+  {
+    mk (dst / d);
+
+    try
+    {
+      for (const dir_entry& e:
+             dir_iterator (src / d, true /* ignore_dangling */))
+      {
+        path f (d / e.path ());
+
+        switch (e.type ())
+        {
+        case entry_type::directory:
+          {
+            copy_configuration (src, dst, path_cast<dir_path> (move (f)));
+            break;
+          }
+        case entry_type::regular:
+          {
+            if (f == stamp_file || f == lock_file || f == test_cache_file)
+              break;
+
+            try
+            {
+              cpfile (src / f, dst / f, cpflags::copy_timestamps);
+            }
+            catch (const system_error& e)
+            {
+              fail << "unable to copy file " << src / f << " to " << dst / f
+                   << ": " << e;
+            }
+
+            break;
+          }
+        default: break;
+        }
+      }
+    }
+    catch (const system_error& e)
+    {
+      fail << "unable to iterate over " << src / d << ": " << e;
+    }
+  }
+
+  static int
+  cmd_config_clone (cmd_config_options& o, cli::scanner& args)
+  {
+    tracer trace ("config_clone");
+
+    // Similar to rename, the new name is the last configuration name unless
+    // it is the only configuration specification.
+    //
+    optional<string> name;
+    {
+      strings& ns (o.config_name ());
+      size_t n (ns.size ());
+
+      if (n > 1 || (n == 1 && (o.config_specified () ||
+                               o.config_id_specified ())))
+      {
+        name = move (ns.back ());
+        ns.pop_back ();
+
+        if (name->empty ())
+          fail << "empty configuration name specified";
+      }
+    }
+
+    // The optional new configuration directory followed by the
+    // configuration variables.
+    //
+    dir_path path;
+    strings vars;
+    while (args.more ())
+    {
+      const char* a (args.next ());
+
+      if (strchr (a, '=') != nullptr)
+      {
+        vars.push_back (a);
+        continue;
+      }
+
+      if (!path.empty () || !vars.empty ())
+        fail << "'" << a << "' does not look like a variable assignment";
+
+      try
+      {
+        path = dir_path (a);
+      }
+      catch (const invalid_path&)
+      {
+        fail << "invalid configuration directory '" << a << "'";
+      }
+    }
+
+    dir_path prj (find_project (o));
+
+    if (path.empty ())
+    {
+      if (!name)
+        fail << "configuration name or directory argument expected";
+
+      path  = prj;
+      path += '-';
+      path += *name;
+    }
+
+    path.complete ();
+    path.normalize ();
+
+    if (exists (path))
+      fail << "configuration directory " << path << " already exists";
+
+    verify_configuration_path (path,
+                               prj,
+                               load_packages (prj, true /* allow_empty */));
+
+    database db (open (prj, trace));
+
+    shared_ptr<configuration> src;
+    {
+      transaction t (db.begin ());
+
+      configurations cfgs (
+        find_configurations (o,
+                             prj,
+                             t,
+                             false /* fallback_default */,
+                             true  /* validate         */));
+
+      t.commit ();
+
+      if (cfgs.size () > 1)
+        fail << "multiple configurations specified for config clone";
+
+      src = move (cfgs.front ());
+    }
+
+    if (path.sub (src->path))
+      fail << "configuration directory " << path << " is inside source "
+           << "configuration " << *src;
+
+    // The clone would inherit the packages and repositories of the other
+    // projects that use the source configuration but only this project
+    // would be associated with it and so nothing would ever synchronize or
+    // drop them.
+    //
+    {
+      dir_paths ps (configuration_projects (o, src->path, prj));
+
+      if (!ps.empty ())
+      {
+        diag_record dr (fail);
+        dr << "configuration " << *src << " is also used by other projects";
+
+        for (const dir_path& d: ps)
+          dr << info << "project " << d;
+      }
+    }
+
+    // Copy the configuration, update the configuration variables, if any,
+    // and then add it to the project database with the same packages
+    // initialized. Clean up the directory if anything goes wrong before the
+    // configuration is added.
+    //
+    // Note that while the copied package database is valid as is (it refers
+    // to the packages inside the configuration relative to its directory and
+    // to the project packages by their absolute source directories), the
+    // copied build state is not: the auxiliary dependency information (depdb,
+    // .d files) contains absolute paths into the source configuration. So we
+    // clean the copied packages and let the clone build from scratch. What
+    // we still save is fetching the repositories, resolving the
+    // dependencies, and fetching and unpacking the dependency packages.
+    //
+    auto_rmdir cleanup (path);
+
+    copy_configuration (src->path, path);
+
+    if (!vars.empty ())
+      run_b (o, "configure:", path.representation (), vars);
+
+    run_b (o, "clean:", path.representation ());
+
+    shared_ptr<configuration> c;
+    {
+      transaction t (db.begin ());
+
+      c = add_configuration (o,
+                             prj,
+                             package_locations {}, // Already verified.
+                             db,
+                             path,
+                             move (name),
+                             nullopt /* id */);
+
+      c->packages = src->packages;
+      db.update (c);
+
+      t.commit ();
+    }
+
+    cleanup.cancel ();
+
+    if (verb)
+    {
+      diag_record dr (text);
+      dr << "cloned configuration ";
+      print_configuration (dr, c);
+      dr << " from " << *src;
+    }
+
+    // Since the repository state has been copied, there is no need to fetch.
+    // And since the packages are already configured, the synchronization is
+    // normally a noop except for configuring forwarding if the configuration
+    // is forwarded.
+    //
+    if (!c->packages.empty ())
+      cmd_sync (o,
+                prj,
+                c,
+                strings () /* pkg_args */,
+                false      /* implicit */,
+                false      /* fetch    */);
+
+    return 0;
+  }
+
   static int
   cmd_config_rename (cmd_config_options& o, cli::scanner& args)
   {
@@ -753,7 +1259,7 @@ namespace bdep
     //
     if (const char* n = cmd_config_validate_add (o))
     {
-      if (!c.add () && !c.create () && !c.set ())
+      if (!c.add () && !c.create () && !c.set () && !c.clone ())
         fail << n << " not valid for this subcommand";
 
       if (o.wipe () && !c.create ())
@@ -764,19 +1270,21 @@ namespace bdep
     //
     if (o.all ())
     {
-      if (!c.list () && !c.remove () && !c.set ())
+      if (!c.list () && !c.remove () && !c.set () && !c.relocate ())
         fail << "--all not valid for this subcommand";
     }
 
     // Dispatch to subcommand function.
     //
-    if (c.add    ()) return cmd_config_add    (o, scan);
-    if (c.create ()) return cmd_config_create (o, scan);
-    if (c.list   ()) return cmd_config_list   (o, scan);
-    if (c.move   ()) return cmd_config_move   (o, scan);
-    if (c.rename ()) return cmd_config_rename (o, scan);
-    if (c.remove ()) return cmd_config_remove (o, scan);
-    if (c.set    ()) return cmd_config_set    (o, scan);
+    if (c.add      ()) return cmd_config_add      (o, scan);
+    if (c.create   ()) return cmd_config_create   (o, scan);
+    if (c.clone    ()) return cmd_config_clone    (o, scan);
+    if (c.list     ()) return cmd_config_list     (o, scan);
+    if (c.move     ()) return cmd_config_move     (o, scan);
+    if (c.relocate ()) return cmd_config_relocate (o, scan);
+    if (c.rename   ()) return cmd_config_rename   (o, scan);
+    if (c.remove   ()) return cmd_config_remove   (o, scan);
+    if (c.set      ()) return cmd_config_set      (o, scan);
 
     assert (false); // Unhandled (new) subcommand.
     return 1;
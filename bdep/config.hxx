@@ -34,6 +34,20 @@ namespace bdep
                      optional<string>          name,
                      optional<uint64_t>        id = nullopt);
 
+  // Create the configurations in the specified directories passing the
+  // corresponding arguments to bpkg-cfg-create in parallel (see
+  // parallel_jobs()) and then add them all in a single transaction. The
+  // configuration directory can also be specified as @<cfg-name> (see
+  // config-add for details).
+  //
+  configurations
+  cmd_config_create_matrix (const common_options&,
+                            const configuration_add_options&,
+                            const dir_path&                  prj,
+                            const package_locations&,
+                            database&,
+                            vector<pair<dir_path, strings>>  cfgs);
+
   int
   cmd_config (cmd_config_options&&, cli::scanner& args);
 
@@ -7,6 +7,7 @@
 #include <odb/schema-catalog.hxx>
 #include <odb/sqlite/exceptions.hxx>
 
+#include <bdep/stat.hxx>
 #include <bdep/diagnostics.hxx>
 
 #include <bdep/database-views.hxx>
@@ -23,6 +24,7 @@ namespace bdep
   open (const dir_path& d, tracer& tr, bool create)
   {
     tracer trace ("open");
+    stat_phase sp ("database open");
 
     path f (d / bdep_file);
 
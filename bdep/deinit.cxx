@@ -9,7 +9,7 @@
 #include <bdep/database.hxx>
 #include <bdep/diagnostics.hxx>
 
-#include <bdep/sync.hxx> // configuration_projects(), hook_file
+#include <bdep/sync.hxx> // configuration_projects(), hook_file, etc
 
 using namespace std;
 
@@ -19,12 +19,14 @@ namespace bdep
   cmd_deinit (const cmd_deinit_options& o,
               const dir_path& prj,
               const shared_ptr<configuration>& c,
-              const strings& pkgs)
+              const strings& pkgs,
+              bool name_cfg)
   {
     bool force (o.force ());
     const dir_path& cfg (c->path);
 
-    // Remove auto-synchronization build system hook.
+    // Remove auto-synchronization build system hook as well as
+    // synchronization stamp and lock.
     //
     // We have to check if there are any other projects that share this
     // configuration. Note that we don't load the other project's database,
@@ -33,23 +35,40 @@ namespace bdep
     // have been removed from the configuration's repositories if that were
     // the case).
     //
-    if (!force               &&
-        c->auto_sync         &&
-        c->packages.empty () &&
-        configuration_projects (o, cfg, prj).empty ())
+    // Note also that we only query the configuration (which involves running
+    // bpkg) if there is something to remove.
+    //
+    if (!force && c->auto_sync && c->packages.empty ())
     {
-      path f (cfg / hook_file);
-      if (exists (f))
-        rm (f);
+      path hf (cfg / hook_file);
+      path sf (cfg / stamp_file);
+      path lf (cfg / lock_file);
+
+      bool he (exists (hf));
+      bool se (exists (sf));
+      bool le (exists (lf));
+
+      if ((he || se || le) && configuration_projects (o, cfg, prj).empty ())
+      {
+        if (he) rm (hf);
+        if (se) rm (sf);
+        if (le) rm (lf);
+      }
     }
 
     // Disfigure configuration forwarding. Note that we have to do this even
     // if forced.
     //
+    // We disfigure all the packages with a single build system invocation.
+    // Note that forward is the meta-operation parameter and so must follow
+    // the last target, that is, disfigure: a@b c@d,forward.
+    //
     if (c->forward)
     {
       package_locations pls (load_packages (prj));
 
+      strings bspec;
+
       for (const string& n: pkgs)
       {
         dir_path out (dir_path (cfg) /= n);
@@ -68,10 +87,13 @@ namespace bdep
           src /= i->path;
         }
 
-        run_b (o,
-               "disfigure:",
-               src.representation () + '@' + out.representation () +
-               ",forward");
+        bspec.push_back (src.representation () + '@' + out.representation ());
+      }
+
+      if (!bspec.empty ())
+      {
+        bspec.back () += ",forward";
+        run_b (o, "disfigure:", bspec);
       }
     }
 
@@ -79,13 +101,21 @@ namespace bdep
     // that are managed by bdep, then its view of what has been initialized
     // in the configuration will become invalid.
     //
+    // If requested, include the configuration name into the plan header
+    // (see cmd_sync() for details).
+    //
     if (!force)
       run_bpkg (2,
                 o,
                 "drop",
                 "-d", cfg,
                 "--keep-dependent",
-                "--plan", "synchronizing:",
+                "--plan", (name_cfg
+                           ? "synchronizing " + (c->name
+                                                 ? '@' + *c->name
+                                                 : cfg.representation ()) +
+                             ':'
+                           : string ("synchronizing:")),
                 "--yes",
                 pkgs);
   }
@@ -137,26 +167,86 @@ namespace bdep
         pkgs.push_back (p.name.string ());
     }
 
-    // Deinitialize in each configuration skipping empty ones.
+    // Collect packages to drop and remove them from the configuration.
+    //
+    auto remove_packages = [all, &pkgs] (const shared_ptr<configuration>& c,
+                                         bool name_cfg = false)
+    {
+      strings r;
+
+      if (all)
+      {
+        for (const package_state& p: c->packages)
+          r.push_back (p.name.string ());
+      }
+      else
+        r = pkgs;
+
+      c->packages.erase (
+        remove_if (c->packages.begin (),
+                   c->packages.end (),
+                   [&r] (const package_state& p)
+                   {
+                     return find_if (r.begin (),
+                                     r.end (),
+                                     [&p] (const string& n)
+                                     {
+                                       return p.name == n;
+                                     }) != r.end ();
+                   }),
+        c->packages.end ());
+
+      // If we are deinitializing multiple packages, print their names. If
+      // requested, also include the configuration name/directory.
+      //
+      if (verb && r.size () > 1)
+      {
+        for (const string& n: r)
+        {
+          diag_record dr (text);
+          dr << "deinitializing package " << n;
+
+          if (name_cfg)
+            dr << " in configuration " << *c;
+        }
+      }
+
+      return r;
+    };
+
+    // Remove our repository from the configuration if we have no more
+    // packages that are initialized in it.
     //
-    // We do each configuration in a separate transaction so that our state
-    // reflects the bpkg configuration as closely as possible.
+    auto remove_repository = [&o, &prj, force] (
+      const shared_ptr<configuration>& c)
+    {
+      if (!force && c->packages.empty ())
+        run_bpkg (3,
+                  o,
+                  "remove",
+                  "-d", c->path,
+                  "dir:" + prj.string ());
+    };
+
+    // Print the configuration header, unless requested not to, returning
+    // false if the configuration is empty and should be skipped.
     //
     bool first (true);
-    for (const shared_ptr<configuration>& c: cfgs)
+    auto print_config = [&cfgs, &first] (const shared_ptr<configuration>& c,
+                                         bool header = true)
     {
       if (c->packages.empty ())
       {
         if (verb)
           info << "skipping empty configuration " << *c;
 
-        continue;
+        return false;
       }
 
       // If we are printing multiple configurations, separate them with a
       // blank line and print the configuration name/directory.
       //
-      if (verb && cfgs.size () > 1)
+      if (verb && header && cfgs.size () > 1)
       {
         text << (first ? "" : "\n")
              << "in configuration " << *c << ':';
@@ -164,58 +254,107 @@ namespace bdep
         first = false;
       }
 
-      transaction t (db.begin ());
+      return true;
+    };
 
-      // Collect packages to drop and remove them from the configuration.
-      //
-      if (all)
+    // Deinitialize in each configuration skipping empty ones.
+    //
+    // Unless asked to use multiple jobs, we do each configuration in a
+    // separate transaction so that our state reflects the bpkg configuration
+    // as closely as possible.
+    //
+    size_t n (cfgs.size ());
+    size_t jobs (n > 1 ? parallel_jobs (o, 1) : 1);
+
+    if (jobs == 1)
+    {
+      for (const shared_ptr<configuration>& c: cfgs)
       {
-        pkgs.clear ();
+        if (!print_config (c))
+          continue;
 
-        for (const package_state& p: c->packages)
-          pkgs.push_back (p.name.string ());
-      }
+        transaction t (db.begin ());
 
-      c->packages.erase (
-        remove_if (c->packages.begin (),
-                   c->packages.end (),
-                   [&pkgs] (const package_state& p)
-                   {
-                     return find_if (pkgs.begin (),
-                                     pkgs.end (),
-                                     [&p] (const string& n)
-                                     {
-                                       return p.name == n;
-                                     }) != pkgs.end ();
-                   }),
-        c->packages.end ());
+        strings ps (remove_packages (c));
 
-      // If we are deinitializing multiple packages, print their names.
-      //
-      if (verb && pkgs.size () > 1)
-      {
-        for (const string& n: pkgs)
-          text << "deinitializing package " << n;
+        // The same story as in init with regard to the state update order.
+        //
+        cmd_deinit (o, prj, c, ps, false /* name_cfg */);
+
+        db.update (c);
+        t.commit ();
+
+        remove_repository (c);
       }
 
-      // The same story as in init with regard to the state update order.
-      //
-      cmd_deinit (o, prj, c, pkgs);
+      return 0;
+    }
 
-      db.update (c);
-      t.commit ();
+    // Otherwise, deinitialize all the configurations in parallel and then
+    // update the database of those that succeeded (one transaction per
+    // configuration, the same as above). Note that since the output of the
+    // threads may interleave, we don't print the configuration headers but
+    // rather include the configuration names into the diagnostics and the
+    // drop plans (the same as in init).
+    //
+    vector<strings> ps (n); // Empty if skipped.
 
-      // Remove our repository from the configuration if we have no more
-      // packages that are initialized in it.
-      //
-      if (!force && c->packages.empty ())
-        run_bpkg (3,
-                  o,
-                  "remove",
-                  "-d", c->path,
-                  "dir:" + prj.string ());
+    for (size_t i (0); i != n; ++i)
+    {
+      if (print_config (cfgs[i], false /* header */))
+        ps[i] = remove_packages (cfgs[i], true /* name_cfg */);
+    }
+
+    vector<uint8_t> ok (n, 0); // Note: not vector<bool> (concurrent writes).
+
+    parallel_for (
+      n,
+      jobs,
+      [&o, &prj, &cfgs, &ps, &ok] (size_t i)
+      {
+        if (ps[i].empty ())
+          return;
+
+        try
+        {
+          cmd_deinit (o, prj, cfgs[i], ps[i], true /* name_cfg */);
+          ok[i] = 1;
+        }
+        catch (const failed&)
+        {
+          // Diagnostics has already been issued. Carry on with the other
+          // configurations.
+        }
+      });
+
+    bool r (true);
+    for (size_t i (0); i != n; ++i)
+    {
+      if (ok[i] != 0)
+      {
+        transaction t (db.begin ());
+        db.update (cfgs[i]);
+        t.commit ();
+      }
+      else if (!ps[i].empty ())
+        r = false;
     }
 
+    // Finally, remove the repository from the configurations that are now
+    // empty, also in parallel.
+    //
+    parallel_for (
+      n,
+      jobs,
+      [&cfgs, &ok, &remove_repository] (size_t i)
+      {
+        if (ok[i] != 0)
+          remove_repository (cfgs[i]);
+      });
+
+    if (!r)
+      throw failed ();
+
     return 0;
   }
 }
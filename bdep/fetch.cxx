@@ -17,6 +17,8 @@ namespace bdep
              const shared_ptr<configuration>& c,
              bool full)
   {
+    stat_phase sp ("fetch");
+
     // Let's use the repository name rather than the location as a sanity
     // check (the repository must have been added as part of init).
     //
@@ -27,41 +29,105 @@ namespace bdep
               (full ? nullptr : ("dir:" + prj.string ()).c_str ()));
   }
 
-  int
-  cmd_fetch (const cmd_fetch_options& o, cli::scanner&)
+  void
+  cmd_fetch (const common_options& o,
+             const dir_path& prj,
+             const configurations& cfgs,
+             bool full)
   {
-    tracer trace ("fetch");
+    configurations cs;
+    for (const shared_ptr<configuration>& c: cfgs)
+    {
+      if (c->packages.empty ())
+        info << "no packages initialized in configuration " << *c;
+      else
+        cs.push_back (c);
+    }
 
-    dir_path prj (find_project (o));
-    database db (open (prj, trace));
+    size_t n (cs.size ());
 
-    transaction t (db.begin ());
-    configurations cfgs (find_configurations (o, prj, t));
-    t.commit ();
+    // Note that while the same remote repositories are normally used in
+    // all the configurations, bpkg has no way to share the fetched metadata
+    // between them. So instead, if requested with --jobs (the same as in
+    // init and deinit), we perform the fetches in parallel which (being
+    // mostly I/O-bound) makes fetching in M configurations take about as
+    // long as in one.
+    //
+    size_t jobs (n > 1 ? parallel_jobs (o, 1) : 1);
 
-    bool first (true);
-    for (const shared_ptr<configuration>& c: cfgs)
+    if (jobs == 1)
     {
-      if (c->packages.empty ())
+      bool first (true);
+      for (const shared_ptr<configuration>& c: cs)
       {
-        info << "no packages initialized in configuration " << *c;
-        continue;
+        // If we are fetching in multiple configurations, separate them with
+        // a blank line and print the configuration name/directory.
+        //
+        if (verb && cfgs.size () > 1)
+        {
+          text << (first ? "" : "\n")
+               << "fetching in configuration " << *c;
+
+          first = false;
+        }
+
+        cmd_fetch (o, prj, c, full);
       }
 
-      // If we are fetching in multiple configurations, separate them with a
-      // blank line and print the configuration name/directory.
-      //
-      if (verb && cfgs.size () > 1)
+      return;
+    }
+
+    // Note that since the output of the threads may interleave, we don't
+    // print the configuration headers (the same as in init) but rather
+    // identify the configurations in which fetching has failed at the end.
+    //
+    vector<uint8_t> ok (n, 0); // Note: not vector<bool> (concurrent writes).
+
+    parallel_for (
+      n,
+      jobs,
+      [&o, &prj, &cs, full, &ok] (size_t i)
       {
-        text << (first ? "" : "\n")
-             << "fetching in configuration " << *c;
+        try
+        {
+          cmd_fetch (o, prj, cs[i], full);
+          ok[i] = 1;
+        }
+        catch (const failed&)
+        {
+          // Diagnostics has already been issued. Carry on with the other
+          // configurations.
+        }
+      });
 
-        first = false;
+    bool r (true);
+    for (size_t i (0); i != n; ++i)
+    {
+      if (!ok[i])
+      {
+        error << "unable to fetch in configuration " << *cs[i];
+        r = false;
       }
-
-      cmd_fetch (o, prj, c, o.full ());
     }
 
+    if (!r)
+      throw failed ();
+  }
+
+  int
+  cmd_fetch (const cmd_fetch_options& o, cli::scanner&)
+  {
+    tracer trace ("fetch");
+
+    dir_path prj (find_project (o));
+    database db (open (prj, trace));
+
+    transaction t (db.begin ());
+    configurations cfgs (find_configurations (o, prj, t));
+    t.commit ();
+
+    cmd_fetch (o, prj, cfgs, o.full ());
+
     return 0;
   }
 }
@@ -19,6 +19,16 @@ namespace bdep
              const shared_ptr<configuration>&,
              bool full);
 
+  // Fetch in multiple configurations in parallel (see --jobs), skipping
+  // those without any packages initialized. If fetching in some
+  // configurations fails, still complete it in the others and then fail.
+  //
+  void
+  cmd_fetch (const common_options&,
+             const dir_path& prj,
+             const configurations&,
+             bool full);
+
   int
   cmd_fetch (const cmd_fetch_options&, cli::scanner& args);
 }
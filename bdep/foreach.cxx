@@ -0,0 +1,201 @@
+// file      : bdep/foreach.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <bdep/foreach.hxx>
+
+#include <sstream>  // ostringstream
+#include <iostream> // cout
+
+#include <bdep/project.hxx>
+#include <bdep/database.hxx>
+#include <bdep/diagnostics.hxx>
+
+using namespace std;
+
+namespace bdep
+{
+  // Replace the {cfg-dir} and {cfg-name} placeholders in the argument.
+  //
+  static string
+  substitute (const string& a, const configuration& c)
+  {
+    string r;
+
+    for (size_t i (0); i != a.size (); )
+    {
+      size_t p (a.find ('{', i));
+
+      if (p == string::npos)
+      {
+        r.append (a, i, string::npos);
+        break;
+      }
+
+      r.append (a, i, p - i);
+
+      if (a.compare (p, 9, "{cfg-dir}") == 0)
+      {
+        r += c.path.string ();
+        i = p + 9;
+      }
+      else if (a.compare (p, 10, "{cfg-name}") == 0)
+      {
+        if (c.name)
+          r += *c.name;
+
+        i = p + 10;
+      }
+      else
+      {
+        r += '{';
+        i = p + 1;
+      }
+    }
+
+    return r;
+  }
+
+  int
+  cmd_foreach (const cmd_foreach_options& o, cli::scanner& args)
+  {
+    tracer trace ("foreach");
+
+    strings cmd;
+    for (; args.more (); cmd.push_back (args.next ())) ;
+
+    if (cmd.empty ())
+      fail << "command expected" <<
+        info << "run 'bdep help foreach' for more information";
+
+    dir_path prj (find_project (o));
+
+    database db (open (prj, trace));
+
+    transaction t (db.begin ());
+    configurations cfgs (find_configurations (o, prj, t));
+    t.commit ();
+
+    size_t n (cfgs.size ());
+
+    // Execute the command in each configuration buffering its output (both
+    // stdout and stderr) in a temporary file so that the output of the
+    // concurrently executed commands doesn't interleave. Note that we
+    // create the files in the main thread since tmp_file() is not
+    // thread-safe.
+    //
+    vector<auto_rmfile> outs;
+    for (size_t i (0); i != n; ++i)
+      outs.push_back (auto_rmfile (tmp_file ("foreach")));
+
+    // Note that we don't let the failure to run the command in one
+    // configuration stop the others or lose their output. Instead, we
+    // record the failure (leaving the exit status absent) and report it
+    // together with the output.
+    //
+    vector<optional<process_exit>> exits (n);
+    strings errors (n); // Failure description, if any.
+
+    parallel_for (
+      n,
+      n > 1 ? parallel_jobs (o) : 1,
+      [&o, &cmd, &cfgs, &outs, &exits, &errors] (size_t i)
+      {
+        const configuration& c (*cfgs[i]);
+
+        strings as;
+        for (const string& a: cmd)
+          as.push_back (substitute (a, c));
+
+        string p (move (as.front ()));
+        as.erase (as.begin ());
+
+        try
+        {
+          auto_fd fd (fdopen (outs[i].path,
+                              fdopen_mode::out    |
+                              fdopen_mode::create |
+                              fdopen_mode::truncate));
+
+          process pr (start (0 /* stdin */,
+                             fd.get () /* stdout */,
+                             fd.get () /* stderr */,
+                             p,
+                             as));
+          fd.close ();
+
+          stat_wait (pr);
+          exits[i] = *pr.exit;
+        }
+        catch (const io_error& e)
+        {
+          ostringstream os;
+          os << "unable to open " << outs[i].path << ": " << e;
+          errors[i] = os.str ();
+        }
+        catch (const process_error& e)
+        {
+          ostringstream os;
+          os << "unable to wait for " << p << ": " << e;
+          errors[i] = os.str ();
+        }
+        catch (const failed&)
+        {
+          // Diagnostics has already been issued.
+        }
+      });
+
+    // Print the output and the exit status for each configuration in order.
+    //
+    bool r (true);
+    for (size_t i (0); i != n; ++i)
+    {
+      const configuration& c (*cfgs[i]);
+      const path& f (outs[i].path);
+
+      if (verb && n > 1)
+        cout << (i == 0 ? "" : "\n")
+             << "in configuration " << c << ':' << endl;
+
+      try
+      {
+        ifdstream is (f, fdopen_mode::binary, ifdstream::badbit);
+
+        if (is.peek () != ifdstream::traits_type::eof ())
+          cout << is.rdbuf ();
+
+        is.close ();
+        cout.flush ();
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to read " << f << ": " << e;
+      }
+
+      if (!exits[i])
+      {
+        diag_record dr (error);
+        dr << "unable to run command in configuration " << c;
+
+        if (!errors[i].empty ())
+          dr << ": " << errors[i];
+
+        r = false;
+        continue;
+      }
+
+      const process_exit& e (*exits[i]);
+
+      if (!e)
+      {
+        error << "command " << e << " in configuration " << c;
+        r = false;
+      }
+    }
+
+    if (!r)
+      throw failed ();
+
+    return 0;
+  }
+}
@@ -0,0 +1,19 @@
+// file      : bdep/foreach.hxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef BDEP_FOREACH_HXX
+#define BDEP_FOREACH_HXX
+
+#include <bdep/types.hxx>
+#include <bdep/utility.hxx>
+
+#include <bdep/foreach-options.hxx>
+
+namespace bdep
+{
+  int
+  cmd_foreach (const cmd_foreach_options&, cli::scanner& args);
+}
+
+#endif // BDEP_FOREACH_HXX
@@ -68,7 +68,7 @@ namespace bdep
 
     // Note: cannot use finish() since ignoring normal error.
     //
-    if (!pr.wait ())
+    if (!stat_wait (pr))
     {
       const process_exit& e (*pr.exit);
 
@@ -4,9 +4,11 @@
 
 #include <bdep/http-service.hxx>
 
+#include <chrono>
 #include <cstdlib> // strtoul()
 
-#include <libbutl/fdstream.mxx> // fdterm()
+#include <libbutl/fdstream.mxx>   // fdterm()
+#include <libbutl/filesystem.mxx> // path_entry()
 
 #include <bdep/diagnostics.hxx>
 
@@ -85,9 +87,16 @@ namespace bdep
       if (!progress)
         suppress_progress ();
 
-      // Convert the submit arguments to curl's --form* options.
+      // Convert the submit arguments to curl's --form* options. While at it,
+      // calculate the total size of the files being uploaded.
+      //
+      // Note that curl reads the files itself, streaming them as it sends
+      // the request, so there is no reason for us to read them into memory
+      // and pipe them through.
       //
       strings fos;
+      uint64_t upload_size (0);
+
       for (const parameter& p: params)
       {
         fos.emplace_back (p.type == parameter::file
@@ -97,8 +106,24 @@ namespace bdep
         fos.emplace_back (p.type == parameter::file
                           ? p.name + "=@" + p.value
                           : p.name + "="  + p.value);
+
+        if (p.type == parameter::file)
+        try
+        {
+          pair<bool, entry_stat> pe (
+            path_entry (path (p.value), true /* follow_symlinks */));
+          if (pe.first)
+            upload_size += pe.second.size;
+        }
+        catch (const system_error& e)
+        {
+          fail << "unable to stat " << p.value << ": " << e;
+        }
       }
 
+      using namespace chrono;
+      steady_clock::time_point start_time (steady_clock::now ());
+
       // Note that it's a bad idea to issue the diagnostics while curl is
       // running, as it will be messed up with the progress output. Thus, we
       // throw the runtime_error exception on the HTTP response parsing error
@@ -459,6 +484,23 @@ namespace bdep
 
       assert (!message.empty ());
 
+      // Report the upload throughput. Note that the time includes the
+      // connection establishment and the response receipt and so this is a
+      // lower bound.
+      //
+      if (verb >= 2 && upload_size != 0)
+      {
+        double s (duration_cast<duration<double>> (
+                    steady_clock::now () - start_time).count ());
+
+        diag_record dr (text);
+        dr << "uploaded " << upload_size << " bytes in " << s << 's';
+
+        if (s != 0)
+          dr << " (" << static_cast<uint64_t> (upload_size / s / 1024)
+             << " KB/s)";
+      }
+
       // Print the request failure reason and fail.
       //
       if (!status || *status != 200)
@@ -48,37 +48,28 @@ namespace bdep
             database& db,
             const configurations& cfgs,
             const package_locations& pkgs,
-            const strings& pkg_args)
+            const strings& pkg_args,
+            size_t def_jobs)
   {
-    // We do each configuration in a separate transaction so that our state
-    // reflects the bpkg configuration as closely as possible.
+    // Add project repository to the configuration. Note that we don't fetch
+    // it since sync is going to do it anyway.
     //
-    bool first (true);
-    for (const shared_ptr<configuration>& c: cfgs)
+    auto add_repository = [&o, &prj] (const shared_ptr<configuration>& c)
     {
-      // If we are initializing in multiple configurations, separate them with
-      // a blank line and print the configuration name/directory.
-      //
-      if (verb && cfgs.size () > 1)
-      {
-        text << (first ? "" : "\n")
-             << "in configuration " << *c << ':';
-
-        first = false;
-      }
-
-      // Add project repository to the configuration. Note that we don't fetch
-      // it since sync is going to do it anyway.
-      //
       run_bpkg (3,
                 o,
                 "add",
                 "-d", c->path,
                 "--type", "dir",
                 prj);
+    };
 
-      transaction t (db.begin ());
-
+    // If name_cfg is true, then include the configuration name/directory
+    // into the diagnostics.
+    //
+    auto add_packages = [&pkgs] (const shared_ptr<configuration>& c,
+                                 bool name_cfg = false)
+    {
       for (const package_location& p: pkgs)
       {
         if (find_if (c->packages.begin (),
@@ -89,7 +80,13 @@ namespace bdep
                      }) != c->packages.end ())
         {
           if (verb)
-            info << "package " << p.name << " is already initialized";
+          {
+            diag_record dr (info);
+            dr << "package " << p.name << " is already initialized";
+
+            if (name_cfg)
+              dr << " in configuration " << *c;
+          }
 
           continue;
         }
@@ -97,24 +94,132 @@ namespace bdep
         // If we are initializing multiple packages, print their names.
         //
         if (verb && pkgs.size () > 1)
-          text << "initializing package " << p.name;
+        {
+          diag_record dr (text);
+          dr << "initializing package " << p.name;
+
+          if (name_cfg)
+            dr << " in configuration " << *c;
+        }
 
         c->packages.push_back (package_state {p.name});
       }
+    };
 
-      // Should we sync then commit the database or commit and then sync?
-      // Either way we can end up with an incosistent state. Note, however,
-      // that the state in the build configuration can in most cases be
-      // corrected with a retry (e.g., "upgrade" the package to the fixed
-      // version, etc) while if we think (from the database state) that the
-      // package has already been initialized, then there will be no way to
-      // retry anything.
-      //
-      cmd_sync (o, prj, c, pkg_args, false /* implicit */);
+    // If we are initializing in multiple configurations, separate them with
+    // a blank line and print the configuration name/directory.
+    //
+    bool first (true);
+    auto print_config = [&cfgs, &first] (const shared_ptr<configuration>& c)
+    {
+      if (verb && cfgs.size () > 1)
+      {
+        text << (first ? "" : "\n")
+             << "in configuration " << *c << ':';
+
+        first = false;
+      }
+    };
+
+    // Unless asked to use multiple jobs, we do each configuration in a
+    // separate transaction so that our state reflects the bpkg configuration
+    // as closely as possible.
+    //
+    size_t n (cfgs.size ());
+    size_t jobs (n > 1 ? parallel_jobs (o, def_jobs) : 1);
+
+    if (jobs == 1)
+    {
+      for (const shared_ptr<configuration>& c: cfgs)
+      {
+        print_config (c);
+        add_repository (c);
+
+        transaction t (db.begin ());
+
+        add_packages (c);
+
+        // Should we sync then commit the database or commit and then sync?
+        // Either way we can end up with an incosistent state. Note, however,
+        // that the state in the build configuration can in most cases be
+        // corrected with a retry (e.g., "upgrade" the package to the fixed
+        // version, etc) while if we think (from the database state) that the
+        // package has already been initialized, then there will be no way to
+        // retry anything.
+        //
+        cmd_sync (o, prj, c, pkg_args, false /* implicit */);
+
+        db.update (c);
+        t.commit ();
+      }
+
+      return;
+    }
 
-      db.update (c);
-      t.commit ();
+    // Otherwise, add the repository and synchronize all the configurations
+    // in parallel and then update the database of those that succeeded, the
+    // same as above (one transaction per configuration, only after the
+    // sync). Note that the configurations are marked as being synchronized
+    // before starting the threads (see cmd_sync_mark() for details).
+    //
+    // Also note that since the output of the threads may interleave, we
+    // don't print the configuration headers but rather include the
+    // configuration names into the diagnostics and the synchronization
+    // plans.
+    //
+    for (const shared_ptr<configuration>& c: cfgs)
+    {
+      add_packages (c, true /* name_cfg */);
+      cmd_sync_mark (c->path, false /* implicit */);
     }
+
+    vector<uint8_t> ok (n, 0); // Note: not vector<bool> (concurrent writes).
+
+    parallel_for (
+      n,
+      jobs,
+      [&o, &prj, &cfgs, &pkg_args, &add_repository, &ok] (size_t i)
+      {
+        const shared_ptr<configuration>& c (cfgs[i]);
+
+        try
+        {
+          add_repository (c);
+
+          cmd_sync (o,
+                    prj,
+                    c,
+                    pkg_args,
+                    false /* implicit */,
+                    true  /* fetch    */,
+                    true  /* yes      */,
+                    true  /* name_cfg */,
+                    true  /* marked   */);
+
+          ok[i] = 1;
+        }
+        catch (const failed&)
+        {
+          // Diagnostics has already been issued. Carry on with the other
+          // configurations.
+        }
+      });
+
+    bool r (true);
+    for (size_t i (0); i != n; ++i)
+    {
+      if (ok[i] != 0)
+      {
+        transaction t (db.begin ());
+        db.update (cfgs[i]);
+        t.commit ();
+      }
+      else
+        r = false;
+    }
+
+    if (!r)
+      throw failed ();
   }
 
   int
@@ -124,20 +229,34 @@ namespace bdep
 
     bool ca (o.config_add_specified ());
     bool cc (o.config_create_specified ());
+    bool cm (o.config_create_matrix ());
 
     if (o.empty ())
     {
       if (ca) fail << "both --empty and --config-add specified";
       if (cc) fail << "both --empty and --config-create specified";
+      if (cm) fail << "both --empty and --config-create-matrix specified";
+    }
+
+    if (cm)
+    {
+      if (ca) fail << "both --config-create-matrix and --config-add specified";
+      if (cc) fail << "both --config-create-matrix and --config-create "
+                   << "specified";
+
+      if (o.config_name_specified () || o.config_id_specified ())
+        fail << "configuration name or id specified with "
+             << "--config-create-matrix" <<
+          info << "use @<cfg-name> as configuration directory instead";
     }
 
     if (const char* n = cmd_config_validate_add (o))
     {
-      if (!ca && !cc)
-        fail << n << " specified without --config-(add|create)";
+      if (!ca && !cc && !cm)
+        fail << n << " specified without --config-(add|create|create-matrix)";
 
-      if (o.wipe () && !cc)
-        fail << "--wipe specified without --config-create";
+      if (o.wipe () && !cc && !cm)
+        fail << "--wipe specified without --config-create[-matrix]";
     }
 
     project_packages pp (
@@ -193,6 +312,46 @@ namespace bdep
             ca,
             cc));
       }
+      // --config-create-matrix
+      //
+      else if (cm)
+      {
+        vector<pair<dir_path, strings>> m;
+
+        while (args.more ())
+        {
+          const char* a (args.next ());
+
+          dir_path d;
+          try
+          {
+            d = dir_path (a);
+
+            if (d.empty ())
+              throw invalid_path (a);
+          }
+          catch (const invalid_path&)
+          {
+            fail << "invalid configuration directory '" << a << "'";
+          }
+
+          strings cas;
+          for (cli::scanner& g (args.group ()); g.more (); )
+            cas.push_back (g.next ());
+
+          m.emplace_back (move (d), move (cas));
+        }
+
+        if (m.empty ())
+          fail << "configuration directory argument expected";
+
+        cfgs = cmd_config_create_matrix (o,
+                                         o,
+                                         prj,
+                                         load_packages (prj),
+                                         db,
+                                         move (m));
+      }
       else
       {
         // If this is the default mode, then find the configurations the user
@@ -206,12 +365,15 @@ namespace bdep
 
     // Initialize each package in each configuration.
     //
+    // Note that for the matrix we initialize in parallel by default.
+    //
     cmd_init (o,
               prj,
               db,
               cfgs,
               pp.packages,
-              scan_arguments (args) /* pkg_args */);
+              scan_arguments (args) /* pkg_args */,
+              cm ? 0 : 1            /* jobs     */);
 
     return 0;
   }
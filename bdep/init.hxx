@@ -29,13 +29,17 @@ namespace bdep
   // Initialize each package in each configuration skipping those that are
   // already initialized. Then synchronize each configuration.
   //
+  // If there are multiple configurations, then initialize them in parallel
+  // using parallel_jobs() with the specified default.
+  //
   void
   cmd_init (const common_options&,
             const dir_path& prj,
             database&,
             const configurations&,
             const package_locations&,
-            const strings& pkg_args);
+            const strings& pkg_args,
+            size_t jobs = 1);
 
   int
   cmd_init (const cmd_init_options&, cli::group_scanner& args);
@@ -4,6 +4,10 @@
 
 #include <bdep/new.hxx>
 
+#include <chrono>
+#include <cstring> // strcmp()
+#include <sstream>
+
 #include <libbutl/project-name.mxx>
 
 #include <bdep/project.hxx>
@@ -24,11 +28,113 @@ namespace bdep
   using lang = cmd_new_lang;
   using vcs  = cmd_new_vcs;
 
+  // The project files and directories are first rendered into memory and
+  // then written out in one pass (see write_tree() below).
+  //
+  namespace
+  {
+    struct tree_entry
+    {
+      path             name;    // Absolute path.
+      optional<string> content; // Absent for a directory.
+      bool             append;  // Append to (rather than overwrite) the file.
+    };
+
+    using tree_entries = vector<tree_entry>;
+
+    // Stand-in for ofdstream that renders the file into a memory buffer
+    // and, on close, adds it to the tree.
+    //
+    class tree_ostream: public std::ostringstream
+    {
+    public:
+      explicit
+      tree_ostream (tree_entries& t): tree_ (t) {}
+
+      void
+      open (const path& f, fdopen_mode m = fdopen_mode::none)
+      {
+        file_ = f;
+        append_ = (m & fdopen_mode::append) == fdopen_mode::append;
+
+        str (string ());
+        clear ();
+      }
+
+      void
+      close ()
+      {
+        tree_.push_back (tree_entry {move (file_), str (), append_});
+      }
+
+      // Note: the directory is only created when the tree is written.
+      //
+      void
+      mk (const dir_path& d)
+      {
+        tree_.push_back (tree_entry {d, nullopt, false});
+      }
+
+    private:
+      tree_entries& tree_;
+      path          file_;
+      bool          append_ = false;
+    };
+  }
+
+  // Write the tree. Note that the files being appended to (which are
+  // outside of the directory being created) are written last so that if
+  // anything fails, then the caller only needs to clean up that directory.
+  //
+  static void
+  write_tree (const tree_entries& t)
+  {
+    ofdstream os;
+
+    auto write = [&os] (const tree_entry& e)
+    {
+      if (!e.content)
+      {
+        mk (path_cast<dir_path> (e.name));
+        return;
+      }
+
+      try
+      {
+        os.open (e.name,
+                 fdopen_mode::out    |
+                 fdopen_mode::create |
+                 (e.append ? fdopen_mode::append : fdopen_mode::truncate));
+
+        os << *e.content;
+        os.close ();
+      }
+      catch (const io_error& ex)
+      {
+        fail << "unable to write " << e.name << ": " << ex;
+      }
+    };
+
+    for (const tree_entry& e: t)
+      if (!e.append)
+        write (e);
+
+    for (const tree_entry& e: t)
+      if (e.append)
+        write (e);
+  }
+
+  static int
+  cmd_new_batch (const cmd_new_options&, cli::group_scanner& args);
+
   int
   cmd_new (const cmd_new_options& o, cli::group_scanner& args)
   {
     tracer trace ("new");
 
+    if (o.batch_specified ())
+      return cmd_new_batch (o, args);
+
     bool ca (o.config_add_specified ());
     bool cc (o.config_create_specified ());
 
@@ -203,10 +309,9 @@ namespace bdep
     // Create the output directory and do some sanity check (empty if exists,
     // nested packages, etc; you would be surprised what people come up with).
     //
+    bool oe (exists (out));
     {
-      bool e (exists (out));
-
-      if (e && !empty (out))
+      if (oe && !empty (out))
         fail << "directory " << out << " already exists and is not empty";
 
       if (!o.no_checks ())
@@ -239,10 +344,23 @@ namespace bdep
         }
       }
 
-      if (!e)
+      if (!oe)
         mk (out);
     }
 
+    // If we fail before the project tree is written, then clean up the
+    // output directory (removing it if we have created it) so that we don't
+    // leave a partial project behind.
+    //
+    bool written (false);
+    auto og (
+      make_exception_guard (
+        [&out, oe, &written] ()
+        {
+          if (!written)
+            rm_r (out, !oe /* dir_itself */, 3, rm_error_mode::warn);
+        }));
+
     // Initialize the version control system. Do it before writing anything
     // ourselves in case it fails. Also, the email discovery may do the VCS
     // detection.
@@ -256,10 +374,11 @@ namespace bdep
       }
     }
 
-    for (path f;;) // Breakout loop with file currently being written.
-    try
+    tree_entries tree;
+
+    for (path f;;) // Breakout loop with file currently being rendered.
     {
-      ofdstream os;
+      tree_ostream os (tree);
 
       // .gitignore
       //
@@ -397,7 +516,7 @@ namespace bdep
       // build/
       //
       dir_path bd (dir_path (out) /= "build");
-      mk (bd);
+      os.mk (bd);
 
       // build/bootstrap.build
       //
@@ -501,7 +620,7 @@ namespace bdep
       // <base>/ (source subdirectory).
       //
       dir_path sd (dir_path (out) /= b);
-      mk (sd);
+      os.mk (sd);
 
       switch (t)
       {
@@ -1115,12 +1234,12 @@ namespace bdep
             break;
 
           dir_path td (dir_path (out) /= "tests");
-          mk (td);
+          os.mk (td);
 
           // tests/build/
           //
           dir_path tbd (dir_path (td) /= "build");
-          mk (tbd);
+          os.mk (tbd);
 
           // tests/build/bootstrap.build
           //
@@ -1208,7 +1327,7 @@ namespace bdep
           // tests/basics/
           //
           td /= "basics";
-          mk (td);
+          os.mk (td);
 
           switch (l)
           {
@@ -1318,10 +1437,9 @@ namespace bdep
 
       break;
     }
-    catch (const io_error& e)
-    {
-      fail << "unable to write " << f << ": " << e;
-    }
+
+    write_tree (tree);
+    written = true;
 
     if (verb)
       text << "created new " << t << ' ' << (pkg ? "package" : "project")
@@ -1369,4 +1487,128 @@ namespace bdep
 
     return 0;
   }
+
+  static int
+  cmd_new_batch (const cmd_new_options& o, cli::group_scanner& args)
+  {
+    if (args.more ())
+      fail << "unexpected argument '" << args.next () << "' with --batch";
+
+    const path& f (o.batch ());
+
+    // Parse the entire batch file before creating anything so that we don't
+    // end up with only some of the projects created due to a typo.
+    //
+    struct entry
+    {
+      uint64_t        line;
+      cmd_new_options options;
+      strings         args;
+    };
+
+    vector<entry> es;
+    try
+    {
+      ifdstream is (f);
+
+      string l;
+      for (uint64_t ln (1); !eof (getline (is, l)); ++ln)
+      {
+        strings ws;
+        for (size_t b (0), e (0), n; (n = next_word (l, b, e, ' ', '\t')); )
+          ws.push_back (string (l, b, n));
+
+        if (ws.empty () || ws.front ()[0] == '#')
+          continue;
+
+        // Parse the options and arguments in any order on top of those
+        // specified on the command line (similar to the way it's done for
+        // the command line in main()).
+        //
+        cmd_new_options lo (o);
+        lo.batch_specified (false);
+
+        strings las;
+        try
+        {
+          cli::vector_scanner vs (ws);
+          cli::group_scanner gs (vs);
+
+          for (bool opt (true); gs.more (); )
+          {
+            if (opt)
+            {
+              if (strcmp (gs.peek (), "--") == 0)
+              {
+                gs.next ();
+                opt = false;
+                continue;
+              }
+
+              if (lo.parse (gs))
+                continue;
+            }
+
+            scan_argument (las, gs);
+          }
+        }
+        catch (const cli::exception& e)
+        {
+          fail << f << ':' << ln << ": " << e;
+        }
+
+        if (lo.batch_specified ())
+          fail << f << ':' << ln << ": nested --batch";
+
+        es.push_back (entry {ln, move (lo), move (las)});
+      }
+
+      is.close ();
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to read " << f << ": " << e;
+    }
+
+    using namespace chrono;
+    steady_clock::time_point start (steady_clock::now ());
+
+    for (const entry& e: es)
+    {
+      cli::vector_scanner vs (e.args);
+      cli::group_scanner gs (vs);
+
+      try
+      {
+        int r (cmd_new (e.options, gs));
+
+        if (r != 0)
+          return r;
+
+        // Note that initializing a project also initializes its temporary
+        // directory.
+        //
+        clean_tmp (true /* ignore_errors */);
+      }
+      catch (const failed&)
+      {
+        info << "while creating project/package from " << f << ':' << e.line;
+        throw;
+      }
+    }
+
+    if (verb)
+    {
+      double s (duration_cast<duration<double>> (
+                  steady_clock::now () - start).count ());
+
+      diag_record dr (text);
+      dr << "created " << es.size () << " projects/packages in " << s << 's';
+
+      if (s != 0)
+        dr << " (" << es.size () / s << "/s)";
+    }
+
+    return 0;
+  }
 }
@@ -5,6 +5,9 @@
 #include <bdep/project.hxx>
 #include <bdep/project-odb.hxx>
 
+#include <map>
+#include <mutex>
+
 #include <libbutl/b.mxx>
 #include <libbutl/manifest-parser.mxx>
 
@@ -25,6 +28,8 @@ namespace bdep
                        bool fallback_default,
                        bool validate)
   {
+    stat_phase sp ("configuration lookup");
+
     configurations r;
 
     // Weed out duplicates.
@@ -243,8 +248,13 @@ namespace bdep
     return pls;
   }
 
+  // If deps is not NULL, then also collect the names of the packages each
+  // package depends on (in the same order as pls).
+  //
   static void
-  load_package_names (const dir_path& prj, package_locations& pls)
+  load_package_names (const dir_path& prj,
+                      package_locations& pls,
+                      vector<package_names>* deps = nullptr)
   {
     // Load each package's manifest and obtain its name and project (they are
     // normally at the beginning of the manifest so we could optimize this, if
@@ -268,6 +278,19 @@ namespace bdep
 
         pl.name = move (m.name);
         pl.project = move (m.project);
+
+        if (deps != nullptr)
+        {
+          package_names ds;
+
+          for (const bpkg::dependency_alternatives& da: m.dependencies)
+          {
+            for (const bpkg::dependency& d: da)
+              ds.push_back (d.name);
+          }
+
+          deps->push_back (move (ds));
+        }
       }
       catch (const manifest_parsing& e)
       {
@@ -289,11 +312,142 @@ namespace bdep
     return pls;
   }
 
+  size_t package_graph::
+  find (const package_name& n) const
+  {
+    size_t i (0);
+    for (; i != packages.size () && packages[i].name != n; ++i) ;
+    return i;
+  }
+
+  vector<size_t> package_graph::
+  dependents (const vector<size_t>& ps) const
+  {
+    size_t n (packages.size ());
+
+    vector<bool> r (n, false);
+    for (size_t i: ps)
+      r[i] = true;
+
+    // Iterate until nothing changes. Note that the number of project
+    // packages is normally small and the dependency chains are short.
+    //
+    for (bool changed (true); changed; )
+    {
+      changed = false;
+
+      for (size_t i (0); i != n; ++i)
+      {
+        if (r[i])
+          continue;
+
+        for (size_t d: dependencies[i])
+        {
+          if (r[d])
+          {
+            r[i] = changed = true;
+            break;
+          }
+        }
+      }
+    }
+
+    vector<size_t> rs;
+    for (size_t i (0); i != n; ++i)
+    {
+      if (r[i])
+        rs.push_back (i);
+    }
+
+    return rs;
+  }
+
+  vector<vector<size_t>> package_graph::
+  waves () const
+  {
+    size_t n (packages.size ());
+
+    vector<vector<size_t>> r;
+
+    vector<size_t> ws (n, n); // Package wave or n if not yet assigned.
+    for (size_t m (0); m != n; )
+    {
+      vector<size_t> w;
+
+      for (size_t i (0); i != n; ++i)
+      {
+        if (ws[i] != n)
+          continue;
+
+        if (all_of (dependencies[i].begin (),
+                    dependencies[i].end (),
+                    [&ws, &r] (size_t d)
+                    {
+                      return ws[d] < r.size ();
+                    }))
+          w.push_back (i);
+      }
+
+      if (w.empty ())
+      {
+        diag_record dr (fail);
+        dr << "dependency cycle between project packages";
+
+        for (size_t i (0); i != n; ++i)
+        {
+          if (ws[i] == n)
+            dr << info << "package " << packages[i].name << " is in or "
+               << "depends on the cycle";
+        }
+      }
+
+      for (size_t i: w)
+        ws[i] = r.size ();
+
+      m += w.size ();
+      r.push_back (move (w));
+    }
+
+    return r;
+  }
+
+  package_graph
+  load_package_graph (const dir_path& prj)
+  {
+    package_graph r;
+    r.packages = load_package_locations (prj);
+
+    vector<package_names> deps;
+    load_package_names (prj, r.packages, &deps);
+
+    // Resolve the dependencies on the project packages skipping the rest.
+    //
+    for (const package_names& ds: deps)
+    {
+      vector<size_t> is;
+
+      for (const package_name& d: ds)
+      {
+        size_t i (r.find (d));
+
+        if (i != r.packages.size () &&
+            find (is.begin (), is.end (), i) == is.end ())
+          is.push_back (i);
+      }
+
+      r.dependencies.push_back (move (is));
+    }
+
+    return r;
+  }
+
   project_packages
   find_project_packages (const dir_paths& dirs,
                          bool ignore_packages,
                          bool load_packages)
   {
+    stat_phase sp ("project lookup");
+
     project_packages r;
 
     if (!dirs.empty ())
@@ -440,12 +594,28 @@ namespace bdep
   standard_version
   package_version (const common_options& o, const dir_path& d)
   {
+    // Cache the versions since for a snapshot the calculation involves
+    // running the build system which in turn queries the version control
+    // system. Note that this function can be called concurrently.
+    //
+    static map<dir_path, standard_version> cache;
+    static mutex cache_mutex;
+
+    {
+      lock_guard<mutex> l (cache_mutex);
+
+      auto i (cache.find (d));
+      if (i != cache.end ())
+        return i->second;
+    }
+
     b_project_info pi (package_info (o, d));
 
     if (pi.version.empty ())
       fail << "empty version for package directory " << d;
 
-    return move (pi.version);
+    lock_guard<mutex> l (cache_mutex);
+    return cache.emplace (d, move (pi.version)).first->second;
   }
 
   standard_version
@@ -199,6 +199,44 @@ namespace bdep
   package_locations
   load_packages (const dir_path& prj, bool allow_empty = false);
 
+  // Project package dependency graph.
+  //
+  // Only dependencies on other packages of the same project are considered
+  // with all the dependency alternatives assumed to be in use (so that the
+  // graph is conservative).
+  //
+  struct package_graph
+  {
+    package_locations      packages;
+    vector<vector<size_t>> dependencies; // Indexes into packages.
+
+    // Return the index of the specified package or packages.size () if
+    // there is no such package.
+    //
+    size_t
+    find (const package_name&) const;
+
+    // Return the specified packages together with all their (direct and
+    // indirect) dependents in the ascending index order.
+    //
+    vector<size_t>
+    dependents (const vector<size_t>&) const;
+
+    // Split the packages into dependency-ordered waves: the first wave
+    // contains packages that don't depend on any other project packages,
+    // the second -- packages that only depend on the packages from the
+    // first wave, and so on. Fail if there is a dependency cycle.
+    //
+    vector<vector<size_t>>
+    waves () const;
+  };
+
+  // Load the project packages and their dependency graph from the package
+  // manifests.
+  //
+  package_graph
+  load_package_graph (const dir_path& prj);
+
   struct project_packages
   {
     dir_path          project;
@@ -239,6 +277,10 @@ namespace bdep
   // Determine the version of a package in the specified package (first
   // version) or configuration (second version) directory.
   //
+  // Note that the first version caches the result for the duration of the
+  // process and so should not be used for a package whose version may
+  // change in between (for example, due to a commit).
+  //
   standard_version
   package_version (const common_options&, const dir_path& pkg);
 
@@ -350,7 +350,242 @@ namespace bdep
     //
     // See if this is a VCS repository we recognize.
     //
-    if (ctrl && git_repo)
+    auto control_message = [&pkgs] ()
+    {
+      string r;
+
+      auto pkg_str = [] (const package& p)
+      {
+        return p.name.string () + '/' + p.version.string ();
+      };
+
+      if (pkgs.size () == 1)
+        r = "Add " + pkg_str (pkgs[0]) + " publish authorization";
+      else
+      {
+        r = "Add publish authorizations\n";
+
+        for (const package& p: pkgs)
+        {
+          r += '\n';
+          r += pkg_str (p);
+        }
+      }
+
+      return r;
+    };
+
+    if (ctrl && git_repo && o.no_worktree ())
+    {
+      // Build the new build2-control branch commit directly out of git
+      // objects using a temporary index file rather than checking the branch
+      // out into a separate working tree. This way the cost does not grow
+      // with the number of files on the branch.
+      //
+      // Otherwise, the logic is the same as in the worktree-based
+      // implementation below: create the local branch if it doesn't exist,
+      // fast-forward it over the remote-tracking branch, add the new
+      // authorization files, commit, and push.
+      //
+      const char* ref ("refs/heads/build2-control");
+
+      auto rev_parse = [&prj] (const char* r)
+      {
+        return git_line (git_ver,
+                         prj,
+                         true /* ignore_error */,
+                         "rev-parse",
+                         "--verify",
+                         "-q",
+                         r);
+      };
+
+      optional<string> base (rev_parse (ref));
+      optional<string> remote (
+        rev_parse ("refs/remotes/origin/build2-control"));
+
+      // Note that for the brand new branch we create a root commit that
+      // already contains the authorization files.
+      //
+      bool local_new (!base && !remote);
+
+      if (!base && remote)
+      {
+        run_git (git_ver,
+                 prj,
+                 "branch",
+                 verb < 2 ? "-q" : nullptr,
+                 "build2-control",
+                 "origin/build2-control");
+
+        base = remote;
+      }
+      else if (base && remote && *base != *remote)
+      {
+        // Fast-forward the local branch unless it is ahead of the
+        // remote-tracking one. Fail if they have diverged leaving it to the
+        // user to deal with.
+        //
+        optional<string> mb (git_line (git_ver,
+                                       prj,
+                                       true /* ignore_error */,
+                                       "merge-base",
+                                       *base,
+                                       *remote));
+
+        if (mb && *mb == *base)
+        {
+          run_git (git_ver, prj, "update-ref", ref, *remote, *base);
+          base = remote;
+        }
+        else if (!mb || *mb != *remote)
+          fail << "local build2-control branch has diverged from "
+               << "origin/build2-control" <<
+            info << "run 'git fetch' and merge the branches manually";
+      }
+
+      // Create the new commit.
+      //
+      optional<string> commit;
+      {
+        auto_rmfile ix_rm (tmp_file ("control-index"));
+        auto_rmfile mf_rm (tmp_file ("control-manifest"));
+        const path& mf (mf_rm.path);
+
+        setenv ("GIT_INDEX_FILE", ix_rm.path.string ());
+        auto ig (make_guard ([] () {unsetenv ("GIT_INDEX_FILE");}));
+
+        if (base)
+          run_git (git_ver, prj, "read-tree", *base);
+
+        bool added (false);
+
+        for (const package& p: pkgs)
+        {
+          // Note: git always uses forward slashes as path separators.
+          //
+          string n ("submit/" + string (p.checksum, 0, 16));
+
+          if (base && git_line (git_ver,
+                                prj,
+                                false /* ignore_error */,
+                                "ls-tree",
+                                "--name-only",
+                                *base,
+                                n))
+            continue;
+
+          try
+          {
+            ofdstream os (mf);
+            manifest_serializer s (os, n);
+            p.manifest.serialize_header (s);
+            os.close ();
+          }
+          catch (const manifest_serialization&)
+          {
+            // This shouldn't happen as we just parsed the manifest.
+            //
+            assert (false);
+          }
+          catch (const io_error& e)
+          {
+            fail << "unable to write " << mf << ": " << e;
+          }
+
+          optional<string> h (git_line (git_ver,
+                                        prj,
+                                        false /* ignore_error */,
+                                        "hash-object",
+                                        "-w",
+                                        mf));
+          if (!h)
+            fail << "unable to create git blob object for " << n;
+
+          run_git (git_ver,
+                   prj,
+                   "update-index",
+                   "--add",
+                   "--cacheinfo", "100644," + *h + ',' + n);
+
+          added = true;
+        }
+
+        if (added)
+        {
+          optional<string> tree (git_line (git_ver,
+                                           prj,
+                                           false /* ignore_error */,
+                                           "write-tree"));
+          if (!tree)
+            fail << "unable to create git tree object for build2-control";
+
+          commit = git_line (git_ver,
+                             prj,
+                             false /* ignore_error */,
+                             "commit-tree",
+                             (base
+                              ? cstrings ({"-p", base->c_str ()})
+                              : cstrings ()),
+                             "-m", control_message (),
+                             *tree);
+
+          if (!commit)
+            fail << "unable to create git commit for build2-control";
+
+          // Note that the empty oldvalue makes sure that the brand new
+          // branch does not exist.
+          //
+          run_git (git_ver,
+                   prj,
+                   "update-ref",
+                   ref,
+                   *commit,
+                   base ? *base : string () /* oldvalue */);
+        }
+      }
+
+      // Push even if we haven't committed anything, the same as below.
+      //
+      auto pg (
+        make_exception_guard (
+          [&commit, &base, &prj, ref, local_new] ()
+          {
+            if (commit)
+            try
+            {
+              // See below for why we drop the whole brand new branch.
+              //
+              if (local_new)
+                run_git (git_ver,
+                         prj,
+                         "branch",
+                         verb < 2 ? "-q" : nullptr,
+                         "-D",
+                         "build2-control");
+              else
+                run_git (git_ver, prj, "update-ref", ref, *base, *commit);
+
+              error << "unable to push build2-control branch" <<
+                info << "run 'git fetch' and try again";
+            }
+            catch (const failed&)
+            {
+              // We can't do much here and will leave the user to deal with
+              // the mess.
+            }
+          }));
+
+      if (verb && !o.no_progress ())
+        text << "pushing branch build2-control";
+
+      git_push (o,
+                prj,
+                (!remote ? cstrings ({"--set-upstream"}) : cstrings ()),
+                "origin",
+                "build2-control");
+    }
+    else if (ctrl && git_repo)
     {
       // Checkout the build2-control branch into a separate working tree not
       // to interfere with the user's stuff.
@@ -389,7 +624,7 @@ namespace bdep
                                wd,
                                "build2-control"));
 
-        if (pr.wait ())
+        if (stat_wait (pr))
           return;
 
         if (!q)
@@ -651,35 +886,11 @@ namespace bdep
         // have added but haven't managed to push it on the previous run.
         //
         if (added)
-        {
-          // Format the commit message.
-          //
-          string m;
-
-          auto pkg_str = [] (const package& p)
-          {
-            return p.name.string () + '/' + p.version.string ();
-          };
-
-          if (pkgs.size () == 1)
-            m = "Add " + pkg_str (pkgs[0]) + " publish authorization";
-          else
-          {
-            m = "Add publish authorizations\n";
-
-            for (const package& p: pkgs)
-            {
-              m += '\n';
-              m += pkg_str (p);
-            }
-          }
-
           run_git (git_ver,
                    wd,
                    "commit",
                    verb < 2 ? "-q" : verb > 2 ? "-v" : nullptr,
-                   "-m", m);
-        }
+                   "-m", control_message ());
 
         // If we fail to push the control branch, then revert the commit and
         // advice the user to fetch the repository and re-try.
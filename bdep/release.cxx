@@ -62,6 +62,104 @@ namespace bdep
     using status = git_repository_status;
   }
 
+  // Return the position of the version value in the package manifest file.
+  //
+  // Note that, unlike the full package manifest parsing in cmd_release(), no
+  // value validation is performed and so this function is only suitable for
+  // re-reading the manifests that we have rewritten ourselves.
+  //
+  static manifest_name_value
+  version_position (const path& f)
+  {
+    manifest_name_value r;
+
+    try
+    {
+      ifdstream is (f);
+      manifest_parser p (is,
+                         f.string (),
+                         [&r] (manifest_name_value& nv)
+                         {
+                           if (nv.name == "version")
+                             r = nv;
+
+                           // Only pass through the special start/end
+                           // manifest pairs.
+                           //
+                           return nv.name.empty ();
+                         });
+
+      // Skip to the end of the manifest.
+      //
+      for (manifest_name_value nv (p.next ()); !nv.empty (); nv = p.next ()) ;
+    }
+    catch (const manifest_parsing& e)
+    {
+      fail << "invalid package manifest: " << f << ':'
+           << e.line << ':' << e.column << ": " << e.description;
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to read " << f << ": " << e;
+    }
+
+    if (r.empty ())
+      fail << "no version in package manifest " << f;
+
+    return r;
+  }
+
+  // Rewrite the version value in each package manifest with the version
+  // returned by the specified function. If reposition is true, then also
+  // update the version positions for a subsequent rewrite. On failure, append
+  // the retry hint to the diagnostics.
+  //
+  // Return the manifest paths relative to the project directory, suitable for
+  // staging.
+  //
+  template <typename F>
+  static strings
+  rewrite_versions (project& prj,
+                    bool reposition,
+                    const F& version,
+                    const char* retry = "")
+  {
+    strings r;
+    r.reserve (prj.packages.size ());
+
+    for (package& p: prj.packages)
+    {
+      manifest_name_value& vv (p.version_pos);
+
+      // The IO failure is unlikely to happen (as we have already read the
+      // manifests) but still possible (write permission is denied, device is
+      // full, etc.). In this case we may potentially leave the project in an
+      // inconsistent state as some of the package manifests could have
+      // already been rewritten. As a result, the subsequent bdep-release may
+      // fail due to unstaged changes.
+      //
+      try
+      {
+        manifest_rewriter rw (p.manifest);
+        vv.value = version (p);
+        rw.replace (vv);
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to read/write " << p.manifest << ": " << e <<
+          info << "use 'git checkout' to revert any changes and try again"
+             << retry;
+      }
+
+      if (reposition)
+        vv = version_position (p.manifest);
+
+      r.push_back (p.manifest.leaf (prj.path).string ());
+    }
+
+    return r;
+  }
+
   // The plan_*() functions calculate and set all the new values in the passed
   // project but don't apply any changes.
   //
@@ -641,12 +739,27 @@ namespace bdep
         pls = load_packages (prj.path);
       }
 
-      for (package_location& pl: pls)
+      // Parse each manifest extracting name, version, position, etc.
+      //
+      // Since parsing may involve running the build system (see above), do
+      // it in parallel.
+      //
+      vector<manifest_name_value> vvs (pls.size ());
+
+      parallel_for (pls.size (),
+                    parallel_jobs (o),
+                    [&prj, &pls, &vvs, &parse_manifest] (size_t i)
+                    {
+                      vvs[i] = parse_manifest (
+                        prj.path / pls[i].path / manifest_file);
+                    });
+
+      for (size_t i (0); i != pls.size (); ++i)
       {
-        // Parse each manifest extracting name, version, position, etc.
-        //
+        package_location& pl (pls[i]);
+        manifest_name_value& vv (vvs[i]);
+
         path f (prj.path / pl.path / manifest_file);
-        manifest_name_value vv (parse_manifest (f));
 
         package_name n (move (pl.name));
         standard_version v;
@@ -772,18 +885,20 @@ namespace bdep
         return 1;
     }
 
-    // Stage and commit the project changes.
+    // Stage the rewritten manifests and commit the project changes.
+    //
+    // Note that we shouldn't have any untracked files or unstaged changes
+    // other than our modifications. We, however, may have some changes
+    // staged (see plan_revision() for details) which we commit as well.
     //
-    auto commit_project = [&prj] (const string& msg)
+    auto commit_project = [&prj] (const strings& files, const string& msg)
     {
-      // We shouldn't have any untracked files or unstaged changes other than
-      // our modifications, so -a is good enough.
-      //
+      run_git (git_ver, prj.path, "add", "--", files);
+
       run_git (git_ver,
                prj.path,
                "commit",
                verb < 1 ? "-q" : verb >= 2 ? "-v" : nullptr,
-               "-a",
                "-m", msg);
     };
 
@@ -793,39 +908,18 @@ namespace bdep
     {
       // Rewrite each package manifest.
       //
-      for (package& p: prj.packages)
-      {
-        try
-        {
-          manifest_name_value& vv (p.version_pos);
-
-          // Rewrite the version.
-          //
-          {
-            manifest_rewriter rw (p.manifest);
-            vv.value = p.release_version->string ();
-            rw.replace (vv);
-          }
-
-          // If we also need to open the next development cycle, update the
-          // version position for the subsequent manifest rewrite.
-          //
-          if (prj.open_version)
-            vv = parse_manifest (p.manifest);
-        }
-        // The IO failure is unlikely to happen (as we have already read the
-        // manifests) but still possible (write permission is denied, device
-        // is full, etc.). In this case we may potentially leave the project
-        // in an inconsistent state as some of the package manifests could
-        // have already been rewritten. As a result, the subsequent
-        // bdep-release may fail due to unstaged changes.
-        //
-        catch (const io_error& e)
-        {
-          fail << "unable to read/write " << p.manifest << ": " << e <<
-            info << "use 'git checkout' to revert any changes and try again";
-        }
-      }
+      // If we also need to open the next development cycle, update the
+      // version positions for the subsequent manifest rewrite. Note that
+      // there is no need to fully re-parse the manifests for that since we
+      // have already verified them.
+      //
+      strings fs (
+        rewrite_versions (prj,
+                          static_cast<bool> (prj.open_version),
+                          [] (const package& p)
+                          {
+                            return p.release_version->string ();
+                          }));
 
       // If not committing, then we are done.
       //
@@ -858,7 +952,7 @@ namespace bdep
       else
         m = "Release version " + pkg.release_version->string ();
 
-      commit_project (m);
+      commit_project (fs, m);
     }
 
     // Tag.
@@ -894,35 +988,24 @@ namespace bdep
     {
       string ov (prj.open_version->string ());
 
-      // Rewrite each package manifest (similar code to above).
+      // Rewrite each package manifest.
       //
-      for (package& p: prj.packages)
-      {
-        try
-        {
-          manifest_rewriter rw (p.manifest);
-          p.version_pos.value = ov;
-          rw.replace (p.version_pos);
-        }
-        catch (const io_error& e)
-        {
-          // If we are releasing, then the release/revision version have
-          // already been written to the manifests and the changes have been
-          // committed. Thus, the user should re-try with the --open option
-          // in this case.
-          //
-          fail << "unable to read/write " << p.manifest << ": " << e <<
-            info << "use 'git checkout' to revert any changes and try again"
-               << (pkg.release_version ? " with --open" : "");
-        }
-      }
+      // If we are releasing, then the release/revision version have already
+      // been written to the manifests and the changes have been committed.
+      // Thus, the user should re-try with the --open option in this case.
+      //
+      strings fs (
+        rewrite_versions (prj,
+                          false /* reposition */,
+                          [&ov] (const package&) {return ov;},
+                          pkg.release_version ? " with --open" : ""));
 
       if (!commit)
         return 0;
 
       // Commit the manifest rewrites.
       //
-      commit_project ("Change version to " + ov);
+      commit_project (fs, "Change version to " + ov);
     }
 
     if (push)
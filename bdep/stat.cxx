@@ -0,0 +1,442 @@
+// file      : bdep/stat.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef _WIN32
+#  include <unistd.h>       // getpid(), write()
+#  include <sys/resource.h> // getrusage()
+#else
+#  include <io.h>           // _write()
+#  include <process.h>      // _getpid()
+#endif
+
+#include <bdep/stat.hxx>
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <cstdio>  // snprintf()
+#include <sstream>
+
+#include <libbutl/process-io.mxx> // operator<<(ostream, process_args)
+
+#include <bdep/utility.hxx>
+#include <bdep/diagnostics.hxx>
+
+using namespace std;
+
+namespace bdep
+{
+  using std::chrono::steady_clock;
+  using std::chrono::system_clock;
+
+  bool stat_enabled;
+
+  namespace
+  {
+    struct entry
+    {
+      size_t count = 0;
+      steady_clock::duration wall = steady_clock::duration::zero ();
+      double user = 0;    // Seconds.
+      double sys = 0;     // Seconds.
+      uint64_t rss = 0;   // KB.
+    };
+
+    // Phases and programs (in the order of their first appearance).
+    //
+    struct table
+    {
+      vector<pair<string, entry>> phases;
+      vector<pair<string, entry>> programs;
+
+      entry&
+      find (vector<pair<string, entry>>& es, const string& n)
+      {
+        for (pair<string, entry>& e: es)
+        {
+          if (e.first == n)
+            return e.second;
+        }
+
+        es.emplace_back (n, entry ());
+        return es.back ().second;
+      }
+    };
+
+    struct running
+    {
+      string program;
+      string line;
+      steady_clock::time_point start;
+    };
+  }
+
+  static const steady_clock::time_point start_time (steady_clock::now ());
+
+  static mutex stat_mutex;
+  static table stat_table;
+  static map<process::handle_type, running> stat_running;
+
+  static const char trace_name[] = "BDEP_TRACE_FILE";
+
+  static auto_fd trace_fd;
+  static bool trace_enabled;
+
+  static inline bool
+  enabled ()
+  {
+    return stat_enabled || trace_enabled;
+  }
+
+#ifndef _WIN32
+  static void
+  child_usage (double& user, double& sys, uint64_t& rss)
+  {
+    rusage u;
+    if (getrusage (RUSAGE_CHILDREN, &u) != 0)
+    {
+      user = sys = 0;
+      rss = 0;
+      return;
+    }
+
+    user = u.ru_utime.tv_sec + u.ru_utime.tv_usec / 1e6;
+    sys  = u.ru_stime.tv_sec + u.ru_stime.tv_usec / 1e6;
+
+#ifdef __APPLE__
+    rss = static_cast<uint64_t> (u.ru_maxrss) / 1024; // Bytes.
+#else
+    rss = static_cast<uint64_t> (u.ru_maxrss);        // KB.
+#endif
+  }
+#endif
+
+  // Append a JSON string literal.
+  //
+  static void
+  json_string (string& r, const string& s)
+  {
+    r += '"';
+
+    for (char c: s)
+    {
+      switch (c)
+      {
+      case '"':  r += "\\\""; break;
+      case '\\': r += "\\\\"; break;
+      case '\n': r += "\\n";  break;
+      case '\t': r += "\\t";  break;
+      default:
+        {
+          if (static_cast<unsigned char> (c) < 0x20)
+          {
+            char b[7];
+            snprintf (b, sizeof (b), "\\u%04x", static_cast<unsigned> (c));
+            r += b;
+          }
+          else
+            r += c;
+        }
+      }
+    }
+
+    r += '"';
+  }
+
+  // Write the complete ("X") trace event that has started at the specified
+  // time and ended now. Must be called with stat_mutex locked.
+  //
+  static void
+  trace_event (const char* cat,
+               const string& name,
+               const string& cmd,
+               steady_clock::time_point start,
+               steady_clock::time_point end)
+  {
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    // Note that the events from the nested processes must be on the same
+    // timeline so we use the system clock for the timestamps.
+    //
+    long long d (duration_cast<microseconds> (end - start).count ());
+    long long t (
+      duration_cast<microseconds> (
+        system_clock::now ().time_since_epoch ()).count () -
+      duration_cast<microseconds> (steady_clock::now () - start).count ());
+
+#ifndef _WIN32
+    long long pid (getpid ());
+#else
+    long long pid (_getpid ());
+#endif
+
+    long long tid (hash<thread::id> () (this_thread::get_id ()) % 0x7FFFFFFF);
+
+    string r ("{\"name\":");
+    json_string (r, name);
+    r += ",\"cat\":\"";
+    r += cat;
+    r += "\",\"ph\":\"X\",\"ts\":" + to_string (t) +
+         ",\"dur\":"               + to_string (d) +
+         ",\"pid\":"               + to_string (pid) +
+         ",\"tid\":"               + to_string (tid);
+
+    if (!cmd.empty ())
+    {
+      r += ",\"args\":{\"cmd\":";
+      json_string (r, cmd);
+      r += '}';
+    }
+
+    r += "},\n";
+
+    // Tracing is best-effort so we ignore write errors.
+    //
+#ifndef _WIN32
+    if (write (trace_fd.get (), r.c_str (), r.size ()) == -1)
+      return;
+#else
+    if (_write (trace_fd.get (),
+                r.c_str (),
+                static_cast<unsigned int> (r.size ())) == -1)
+      return;
+#endif
+  }
+
+  void
+  trace_init (const path& f)
+  {
+    path p (f);
+    bool nested (p.empty ());
+
+    if (nested)
+    {
+      optional<string> e (getenv (trace_name));
+
+      if (!e || e->empty ())
+        return;
+
+      p = path (move (*e));
+    }
+    else
+    {
+      p.complete ();
+      p.normalize ();
+    }
+
+    try
+    {
+      trace_fd = butl::fdopen (p,
+                               fdopen_mode::out    |
+                               fdopen_mode::create |
+                               fdopen_mode::binary |
+                               (nested
+                                ? fdopen_mode::append
+                                : fdopen_mode::truncate));
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to open trace file " << p << ": " << e;
+    }
+
+    trace_enabled = true;
+
+    if (!nested)
+    {
+#ifndef _WIN32
+      if (write (trace_fd.get (), "[\n", 2) == -1)
+#else
+      if (_write (trace_fd.get (), "[\n", 2) == -1)
+#endif
+        fail << "unable to write trace file " << p << ": "
+             << system_error (errno, generic_category ()); // Sanitize.
+
+      setenv (trace_name, p.string ());
+    }
+  }
+
+  void stat_command::
+  assign (const char* const args[], size_t n)
+  {
+    if (!enabled ())
+      return;
+
+    program = args[0];
+
+    if (trace_enabled)
+    {
+      ostringstream os;
+      os << butl::process_args {args, n};
+      line = os.str ();
+    }
+  }
+
+  void
+  stat_start (const process& pr, stat_command&& c)
+  {
+    if (!enabled ())
+      return;
+
+    // Group by the program name without the directory.
+    //
+    string n (move (c.program));
+    size_t p (path::traits::rfind_separator (n));
+    if (p != string::npos)
+      n.erase (0, p + 1);
+
+    lock_guard<mutex> l (stat_mutex);
+    stat_running[pr.handle] = running {
+      move (n), move (c.line), steady_clock::now ()};
+  }
+
+  bool
+  stat_wait (process& pr)
+  {
+    if (!enabled ())
+      return pr.wait ();
+
+    // Note that the process handle is gone once we have waited for it.
+    //
+    process::handle_type h (pr.handle);
+
+#ifndef _WIN32
+    double u0, s0;
+    uint64_t r0;
+    child_usage (u0, s0, r0);
+#endif
+
+    bool r (pr.wait ());
+
+    steady_clock::time_point now (steady_clock::now ());
+
+#ifndef _WIN32
+    double u1, s1;
+    uint64_t r1;
+    child_usage (u1, s1, r1);
+#endif
+
+    lock_guard<mutex> l (stat_mutex);
+
+    auto i (stat_running.find (h));
+    if (i != stat_running.end ())
+    {
+      const running& rn (i->second);
+
+      entry& e (stat_table.find (stat_table.programs, rn.program));
+
+      ++e.count;
+      e.wall += now - rn.start;
+#ifndef _WIN32
+      e.user += u1 - u0;
+      e.sys += s1 - s0;
+      e.rss = max (e.rss, r1);
+#endif
+
+      if (trace_enabled)
+        trace_event ("process", rn.program, rn.line, rn.start, now);
+
+      stat_running.erase (i);
+    }
+
+    return r;
+  }
+
+  stat_phase::
+  stat_phase (const char* n)
+      : name_ (n)
+  {
+    if (enabled ())
+      start_ = steady_clock::now ();
+  }
+
+  stat_phase::
+  ~stat_phase ()
+  {
+    if (!enabled ())
+      return;
+
+    steady_clock::time_point now (steady_clock::now ());
+
+    lock_guard<mutex> l (stat_mutex);
+
+    entry& e (stat_table.find (stat_table.phases, name_));
+    ++e.count;
+    e.wall += now - start_;
+
+    if (trace_enabled)
+      trace_event ("phase", name_, string (), start_, now);
+  }
+
+  void
+  stat_print ()
+  {
+    using std::chrono::duration;
+
+    auto sec = [] (steady_clock::duration d)
+    {
+      return chrono::duration_cast<duration<double>> (d).count ();
+    };
+
+    char b[128];
+    auto line = [&b] (const string& n,
+                      size_t c,
+                      double w,
+                      const double* u,
+                      const double* s,
+                      const uint64_t* r)
+    {
+      int i (snprintf (b, sizeof (b), "%-20s %6zu %10.3f",
+                       n.c_str (), c, w));
+
+      if (u != nullptr)
+        snprintf (b + i, sizeof (b) - i, " %10.3f %10.3f %10llu",
+                  *u, *s, static_cast<unsigned long long> (*r));
+
+      text << b;
+    };
+
+    lock_guard<mutex> l (stat_mutex);
+
+    snprintf (b, sizeof (b), "%-20s %6s %10s %10s %10s %10s",
+              "phase/program", "count", "wall s", "user s", "sys s",
+              "rss KB");
+    text << b;
+
+    for (const pair<string, entry>& p: stat_table.phases)
+      line (p.first, p.second.count, sec (p.second.wall),
+            nullptr, nullptr, nullptr);
+
+    for (const pair<string, entry>& p: stat_table.programs)
+    {
+      const entry& e (p.second);
+#ifndef _WIN32
+      line (p.first, e.count, sec (e.wall), &e.user, &e.sys, &e.rss);
+#else
+      line (p.first, e.count, sec (e.wall), nullptr, nullptr, nullptr);
+#endif
+    }
+
+    // Finally, bdep itself (including the time spent waiting for the
+    // children).
+    //
+    double w (sec (steady_clock::now () - start_time));
+#ifndef _WIN32
+    rusage u;
+    if (getrusage (RUSAGE_SELF, &u) == 0)
+    {
+      double us (u.ru_utime.tv_sec + u.ru_utime.tv_usec / 1e6);
+      double ss (u.ru_stime.tv_sec + u.ru_stime.tv_usec / 1e6);
+#ifdef __APPLE__
+      uint64_t r (static_cast<uint64_t> (u.ru_maxrss) / 1024);
+#else
+      uint64_t r (static_cast<uint64_t> (u.ru_maxrss));
+#endif
+      line ("bdep", 1, w, &us, &ss, &r);
+      return;
+    }
+#endif
+    line ("bdep", 1, w, nullptr, nullptr, nullptr);
+  }
+}
@@ -0,0 +1,89 @@
+// file      : bdep/stat.hxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef BDEP_STAT_HXX
+#define BDEP_STAT_HXX
+
+#include <chrono>
+
+#include <bdep/types.hxx> // Note: not <bdep/utility.hxx>
+
+namespace bdep
+{
+  // Execution statistics (--stat) and tracing (--trace-file).
+  //
+  // We record the wall time of our own phases (database open, manifest
+  // loading, etc) as well as the wall time, user and system CPU time, and
+  // peak RSS of the child processes and print the summary on exit.
+  //
+  // Note that the child CPU time and RSS are calculated as the difference in
+  // getrusage(RUSAGE_CHILDREN) around waiting for the process and so are
+  // only exact if we don't wait for several processes at once. Also, the
+  // peak RSS is the maximum over all the children waited for so far. None
+  // of this is available on Windows where we only record the wall time.
+  //
+  extern bool stat_enabled;
+
+  // Start writing the phases and child processes as Chrome trace events to
+  // the specified file or, if it is empty, to the file inherited from the
+  // parent bdep process, if any.
+  //
+  // The file is passed to the nested bdep processes (for example, those
+  // started by the build system hook) via the BDEP_TRACE_FILE environment
+  // variable. They append their events to it which is possible since the
+  // events are written with O_APPEND, one write per event, and the closing
+  // ']' is optional in the trace event JSON array format.
+  //
+  void
+  trace_init (const path&);
+
+  // The child process command line information, captured from the process
+  // start callback (the arguments are no longer available once the process
+  // has been started).
+  //
+  struct stat_command
+  {
+    string program;
+    string line;    // Only if tracing.
+
+    void
+    assign (const char* const args[], size_t n);
+  };
+
+  // Register the child process that has been started.
+  //
+  void
+  stat_start (const process&, stat_command&&);
+
+  // Wait for the child process recording its statistics if enabled. Return
+  // the process::wait() result.
+  //
+  bool
+  stat_wait (process&);
+
+  // Record the phase wall time for as long as the object is alive.
+  //
+  class stat_phase
+  {
+  public:
+    explicit
+    stat_phase (const char* name);
+
+    ~stat_phase ();
+
+    stat_phase (const stat_phase&) = delete;
+    stat_phase& operator= (const stat_phase&) = delete;
+
+  private:
+    const char* name_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  // Print the summary table to stderr.
+  //
+  void
+  stat_print ();
+}
+
+#endif // BDEP_STAT_HXX
@@ -102,6 +102,42 @@ namespace bdep
 
     const dir_path& prj (pp.project);
 
+    // Print the project package dependency graph, if requested. Note that it
+    // is the same for all the configurations.
+    //
+    if (o.graph ())
+    {
+      if (!dep_pkgs.empty ())
+        fail << "dependency package specified with --graph";
+
+      package_graph g (load_package_graph (prj));
+      vector<vector<size_t>> ws (g.waves ());
+
+      for (size_t w (0); w != ws.size (); ++w)
+      {
+        for (size_t i: ws[w])
+        {
+          const package_name& n (g.packages[i].name);
+
+          if (!pp.packages.empty () &&
+              find_if (pp.packages.begin (),
+                       pp.packages.end (),
+                       [&n] (const package_location& pl)
+                       {
+                         return pl.name == n;
+                       }) == pp.packages.end ())
+            continue;
+
+          cout << n << " wave " << w + 1 << endl;
+
+          for (size_t d: g.dependencies[i])
+            cout << "  " << g.packages[d].name << endl;
+        }
+      }
+
+      return 0;
+    }
+
     database db (open (prj, trace));
 
     transaction t (db.begin ());
@@ -113,6 +149,23 @@ namespace bdep
     if (!pp.packages.empty ())
       verify_project_packages (pp, cfgs);
 
+    bool fetch (o.fetch () || o.fetch_full ());
+
+    // If printing multiple configurations, then fetch in all of them upfront
+    // and, if requested, in parallel (see cmd_fetch() for details).
+    //
+    if (fetch && cfgs.size () > 1)
+    {
+      configurations fcs;
+      for (const shared_ptr<configuration>& c: cfgs)
+      {
+        if (!c->packages.empty ())
+          fcs.push_back (c);
+      }
+
+      cmd_fetch (o, prj, fcs, o.fetch_full ());
+    }
+
     // Print status in each configuration skipping empty ones.
     //
     bool first (true);
@@ -137,9 +190,7 @@ namespace bdep
         first = false;
       }
 
-      bool fetch (o.fetch () || o.fetch_full ());
-
-      if (fetch)
+      if (fetch && cfgs.size () == 1)
         cmd_fetch (o, prj, c, o.fetch_full ());
 
       if (dep_pkgs.empty ())
@@ -2,9 +2,26 @@
 // copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
 // license   : MIT; see accompanying LICENSE file
 
+#ifndef _WIN32
+#  include <fcntl.h>  // fcntl()
+#  include <unistd.h> // lseek(), read(), write()
+#else
+#  include <libbutl/win32-utility.hxx>
+
+#  include <io.h>     // _get_osfhandle(), _lseek(), _read(), _write()
+#endif
+
+#ifdef __linux__
+#  include <poll.h>        // poll()
+#  include <sys/inotify.h> // inotify_*()
+#endif
+
 #include <bdep/sync.hxx>
 
-#include <cstring>  // strchr()
+#include <mutex>
+#include <cerrno>
+#include <cstdlib>  // strtoll(), strtoull()
+#include <cstring>  // strchr(), strcmp()
 
 #include <libbpkg/manifest.hxx>
 
@@ -21,10 +38,17 @@ namespace bdep
   const path hook_file (
     dir_path ("build") / "bootstrap" / "pre-bdep-sync.build");
 
+  const path stamp_file (
+    dir_path ("build") / "bootstrap" / "bdep-sync.stamp");
+
+  const path lock_file (
+    dir_path ("build") / "bootstrap" / "bdep-sync.lock");
+
   dir_paths
   configuration_projects (const common_options& co,
                           const dir_path& cfg,
-                          const dir_path& prj)
+                          const dir_path& prj,
+                          bool existing)
   {
     using bpkg::repository_type;
     using bpkg::repository_location;
@@ -92,9 +116,10 @@ namespace bdep
         if (d == prj)
           continue;
 
-        // Next see if it looks like a bdep-managed project.
+        // Next see if it looks like a bdep-managed project (unless it no
+        // longer exists and we were asked to include such directories).
         //
-        if (!exists (d / bdep_file))
+        if (!exists (d / bdep_file) && (existing || exists (d)))
           continue;
 
         r.push_back (move (d));
@@ -131,6 +156,271 @@ namespace bdep
     using projects = small_vector<project, 1>;
   }
 
+  // Configuration synchronization stamp.
+  //
+  // After a successful synchronization we save the list of files that affect
+  // it (the manifests, databases, and git repository state of all the
+  // projects that use this configuration as well as the configuration
+  // database itself) together with their modification times. This allows
+  // the implicit synchronization (and, in particular, the one triggered by
+  // the build system hook) to detect that nothing has changed with a few
+  // stat() calls and without loading any databases or running bpkg.
+  //
+  // Note that the stamp is conservative in that any change to the project
+  // database (e.g., the configuration set --no-auto-sync) invalidates it.
+  //
+  using butl::timestamp;
+  using butl::timestamp_nonexistent;
+
+  using stamp_entries = vector<pair<path, timestamp>>;
+
+  static timestamp
+  mtime (const path& f)
+  {
+    try
+    {
+      return butl::file_mtime (f);
+    }
+    catch (const system_error& e)
+    {
+      fail << "unable to obtain file " << f << " modification time: " << e
+           << endf;
+    }
+  }
+
+  // Return the git repository files that change when a commit is made or
+  // checked out and, as a result, the snapshot version of the project
+  // packages changes: HEAD, the current branch ref (absent if the ref is
+  // packed or HEAD is detached, in which case HEAD itself changes), and the
+  // index. Return an empty list if the project is not a git repository.
+  //
+  // Note that .git can also be a file that points to the repository
+  // directory (submodules, worktrees) in which case we also look for the
+  // ref in the common directory.
+  //
+  static paths
+  git_state_files (const dir_path& prj)
+  {
+    paths r;
+
+    auto read_line = [] (const path& f) -> string
+    {
+      string l;
+
+      try
+      {
+        ifdstream is (f, ifdstream::badbit);
+        getline (is, l);
+        is.close ();
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to read " << f << ": " << e;
+      }
+
+      trim (l);
+      return l;
+    };
+
+    try
+    {
+      dir_path gd (prj / dir_path (".git"));
+      path gf (prj / ".git");
+
+      if (!exists (gd))
+      {
+        if (!exists (gf))
+          return r;
+
+        string l (read_line (gf));
+
+        if (l.compare (0, 8, "gitdir: ") != 0)
+          return r;
+
+        gd = dir_path (string (l, 8));
+
+        if (gd.relative ())
+          gd = prj / gd;
+      }
+
+      dir_path cd (gd);
+      {
+        path f (gd / "commondir");
+
+        if (exists (f))
+        {
+          dir_path d (read_line (f));
+          cd = d.relative () ? gd / d : move (d);
+        }
+      }
+
+      r.push_back (gd / "HEAD");
+      r.push_back (gd / "index");
+
+      string h (read_line (gd / "HEAD"));
+
+      if (h.compare (0, 5, "ref: ") == 0)
+        r.push_back (cd / path (string (h, 5)));
+    }
+    catch (const invalid_path& e)
+    {
+      fail << "invalid git repository path '" << e.path << "' in " << prj;
+    }
+
+    return r;
+  }
+
+  // Return the list of project files that affect the synchronization with
+  // their current modification times.
+  //
+  static stamp_entries
+  stamp_inputs (const projects& prjs)
+  {
+    stamp_entries r;
+
+    auto add = [&r] (path f)
+    {
+      timestamp t (mtime (f));
+      r.emplace_back (move (f), t);
+    };
+
+    for (const project& prj: prjs)
+    {
+      const dir_path& d (prj.path);
+
+      add (d / bdep_file);
+      add (d / repositories_file);
+      add (d / packages_file); // May not exist.
+
+      for (const package_location& pl: load_packages (d))
+        add (d / pl.path / manifest_file);
+    }
+
+    return r;
+  }
+
+  // Add the git repository state of the projects to the stamp entries.
+  // Committing changes the snapshot version of the project packages without
+  // touching any of the stamp inputs above.
+  //
+  // Note that the index is normally refreshed by git while determining the
+  // snapshot version during the synchronization and so, similar to the
+  // configuration database, we only get the modification times after the
+  // synchronization.
+  //
+  static void
+  add_git_state (stamp_entries& es, const projects& prjs)
+  {
+    for (const project& prj: prjs)
+    {
+      for (path& f: git_state_files (prj.path))
+      {
+        timestamp t (mtime (f));
+        es.emplace_back (move (f), t);
+      }
+    }
+  }
+
+  static inline path
+  bpkg_database (const dir_path& cfg)
+  {
+    return cfg / dir_path (".bpkg") / "bpkg.sqlite3";
+  }
+
+  static void
+  remove_stamp (const dir_path& cfg)
+  {
+    path f (cfg / stamp_file);
+
+    if (exists (f))
+      rm (f);
+  }
+
+  static void
+  write_stamp (const dir_path& cfg, stamp_entries&& es)
+  {
+    // Note that the configuration database is modified by the
+    // synchronization itself and so we only get its modification time now.
+    //
+    es.emplace_back (bpkg_database (cfg), timestamp_nonexistent);
+    es.back ().second = mtime (es.back ().first);
+
+    path f (cfg / stamp_file);
+
+    try
+    {
+      dir_path d (f.directory ());
+      if (!exists (d))
+        mk (d);
+
+      ofdstream os (f);
+
+      os << "# Created automatically by bdep." << endl;
+
+      for (const auto& e: es)
+        os << e.second.time_since_epoch ().count () << ' ' << e.first.string ()
+           << endl;
+
+      os.close ();
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to write " << f << ": " << e;
+    }
+  }
+
+  // Return true if the configuration synchronization stamp exists and none
+  // of the files it lists have changed.
+  //
+  static bool
+  check_stamp (const dir_path& cfg)
+  {
+    tracer trace ("check_stamp");
+
+    path f (cfg / stamp_file);
+
+    if (!exists (f))
+      return false;
+
+    try
+    {
+      ifdstream is (f, ifdstream::badbit);
+
+      for (string l; !eof (getline (is, l)); )
+      {
+        if (l.empty () || l[0] == '#')
+          continue;
+
+        size_t p (l.find (' '));
+        if (p == string::npos || p + 1 == l.size ())
+          return false; // Corrupted stamp, re-synchronize.
+
+        const char* b (l.c_str ());
+        char* e (nullptr);
+        long long t (strtoll (b, &e, 10)); // Can't throw.
+
+        if (e != b + p)
+          return false;
+
+        if (mtime (path (string (l, p + 1))).time_since_epoch ().count () != t)
+          return false;
+      }
+
+      is.close ();
+    }
+    catch (const invalid_path&)
+    {
+      return false;
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to read " << f << ": " << e;
+    }
+
+    l4 ([&]{trace << "configuration " << cfg << " is up to date";});
+    return true;
+  }
+
   // Append the list of additional (to origin, if not empty) projects that are
   // using this configuration.
   //
@@ -163,6 +453,15 @@ namespace bdep
                                  transaction::current (*ct);
                              }));
 
+        // Note that the project databases are opened in the exclusive
+        // locking mode and several configurations that use the same project
+        // can be synchronized in parallel (see cmd_init()). So we serialize
+        // the opening, which is cheap compared to the rest of the
+        // synchronization.
+        //
+        static mutex m;
+        lock_guard<mutex> l (m);
+
         {
           database db (open (d, trace));
           transaction t (db.begin ());
@@ -186,6 +485,212 @@ namespace bdep
     }
   }
 
+  // Configuration synchronization lock.
+  //
+  // An advisory per-configuration lock that is held for the duration of the
+  // synchronization in order to coalesce concurrent synchronizations of the
+  // same configuration by multiple processes (for example, several build
+  // system processes that have triggered the hook at the same time). The
+  // lock file also contains the synchronization generation, a counter that
+  // is incremented after each successful synchronization. If we had to wait
+  // for the lock and the generation has changed in the meantime, then the
+  // configuration was synchronized by another process and, if the
+  // synchronization stamp is still valid, there is nothing left for us to
+  // do.
+  //
+  // Note that we cannot deadlock with ourselves (e.g., via the hook
+  // triggered by the build system that we run) since the lock is only
+  // acquired after the configuration has been added to BDEP_SYNCED_CONFIGS
+  // (see synced() below). Note also that the lock file is not removed after
+  // the synchronization since another process may be waiting on it. Instead,
+  // it is removed by deinit together with the stamp.
+  //
+  namespace
+  {
+    class sync_lock
+    {
+    public:
+      explicit
+      sync_lock (const dir_path& cfg);
+
+      ~sync_lock ();
+
+      // Return true if we had to wait for the lock and another process has
+      // completed a synchronization in the meantime.
+      //
+      bool
+      coalesced () const {return coalesced_;}
+
+      // Increment the generation. Should be called after a successful
+      // synchronization.
+      //
+      void
+      increment ();
+
+    private:
+      bool
+      lock (bool wait);
+
+      uint64_t
+      read ();
+
+    private:
+      path     file_;
+      auto_fd  fd_;
+      uint64_t generation_;
+      bool     coalesced_ = false;
+    };
+
+    sync_lock::
+    sync_lock (const dir_path& cfg)
+        : file_ (cfg / lock_file)
+    {
+      dir_path d (file_.directory ());
+      if (!exists (d))
+        mk (d);
+
+      try
+      {
+        fd_ = butl::fdopen (file_,
+                            fdopen_mode::in     |
+                            fdopen_mode::out    |
+                            fdopen_mode::create |
+                            fdopen_mode::binary);
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to open " << file_ << ": " << e;
+      }
+
+      if (lock (false /* wait */))
+        generation_ = read ();
+      else
+      {
+        // Note that reading the generation while the lock is held by another
+        // process is racy. However, the worst that can happen is that we
+        // will synchronize unnecessarily.
+        //
+        uint64_t g (read ());
+
+        if (verb >= 2)
+          text << "waiting for concurrent synchronization of " << cfg;
+
+        lock (true /* wait */);
+
+        generation_ = read ();
+        coalesced_ = (generation_ != g);
+      }
+    }
+
+    sync_lock::
+    ~sync_lock ()
+    {
+      // Closing the file descriptor releases the lock.
+      //
+#ifdef _WIN32
+      OVERLAPPED ov {};
+      UnlockFileEx (reinterpret_cast<HANDLE> (_get_osfhandle (fd_.get ())),
+                    0,
+                    MAXDWORD,
+                    MAXDWORD,
+                    &ov);
+#endif
+    }
+
+    bool sync_lock::
+    lock (bool wait)
+    {
+#ifndef _WIN32
+      struct flock l {};
+      l.l_type = F_WRLCK;
+      l.l_whence = SEEK_SET; // Lock the entire file.
+
+      while (fcntl (fd_.get (), wait ? F_SETLKW : F_SETLK, &l) == -1)
+      {
+        if (errno == EINTR)
+          continue;
+
+        if (!wait && (errno == EACCES || errno == EAGAIN))
+          return false;
+
+        fail << "unable to lock " << file_ << ": "
+             << system_error (errno, generic_category ()); // Sanitize.
+      }
+#else
+      OVERLAPPED ov {};
+      if (!LockFileEx (reinterpret_cast<HANDLE> (_get_osfhandle (fd_.get ())),
+                       LOCKFILE_EXCLUSIVE_LOCK |
+                       (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY),
+                       0,
+                       MAXDWORD,
+                       MAXDWORD,
+                       &ov))
+      {
+        if (!wait && GetLastError () == ERROR_LOCK_VIOLATION)
+          return false;
+
+        fail << "unable to lock " << file_ << ": "
+             << butl::win32::last_error_msg ();
+      }
+#endif
+
+      return true;
+    }
+
+    // The generation is stored as a fixed-width decimal number so that we
+    // never need to truncate the file.
+    //
+    static const size_t generation_width (20);
+
+    uint64_t sync_lock::
+    read ()
+    {
+      char b[generation_width + 1];
+      int fd (fd_.get ());
+
+#ifndef _WIN32
+      ssize_t n (lseek (fd, 0, SEEK_SET) == 0
+                 ? ::read (fd, b, generation_width)
+                 : -1);
+#else
+      int n (_lseek (fd, 0, SEEK_SET) == 0
+             ? _read (fd, b, generation_width)
+             : -1);
+#endif
+
+      if (n <= 0) // Empty (just created) or unreadable.
+        return 0;
+
+      b[n] = '\0';
+      return strtoull (b, nullptr, 10); // Can't throw.
+    }
+
+    void sync_lock::
+    increment ()
+    {
+      string g (to_string (++generation_));
+      g.insert (0, generation_width - g.size (), '0');
+
+      int fd (fd_.get ());
+
+#ifndef _WIN32
+      bool r (lseek (fd, 0, SEEK_SET) == 0 &&
+              ::write (fd, g.c_str (), g.size ()) ==
+              static_cast<ssize_t> (g.size ()));
+#else
+      bool r (_lseek (fd, 0, SEEK_SET) == 0 &&
+              _write (fd, g.c_str (), static_cast<unsigned int> (g.size ())) ==
+              static_cast<int> (g.size ()));
+#endif
+
+      // Not being able to update the generation is not fatal: the worst that
+      // can happen is that a waiting process will synchronize unnecessarily.
+      //
+      if (!r && verb >= 2)
+        warn << "unable to update " << file_;
+    }
+  }
+
   // Sync with optional upgrade.
   //
   // If upgrade is not nullopt, then: If there are dep_pkgs, then we are
@@ -209,6 +714,22 @@ namespace bdep
     assert (origin_config == nullptr || !origin_config->packages.empty ());
     assert (prj_pkgs.empty () || dep_pkgs.empty ()); // Can't have both.
 
+    // If this is an implicit synchronization and nothing has changed since
+    // the last one, then we are done.
+    //
+    bool skippable (implicit && !upgrade && pkg_args.empty ());
+
+    if (skippable && check_stamp (cfg))
+      return;
+
+    // Serialize with concurrent synchronizations of this configuration by
+    // other processes, reusing their result if possible.
+    //
+    sync_lock sl (cfg);
+
+    if (sl.coalesced () && skippable && check_stamp (cfg))
+      return;
+
     projects prjs;
 
     if (origin_config != nullptr)
@@ -217,7 +738,17 @@ namespace bdep
     // Load other projects that might be using the same configuration -- we
     // have to synchronize everything at once.
     //
-    load_implicit (co, cfg, origin_prj, prjs);
+    {
+      stat_phase sp ("implicit project load");
+      load_implicit (co, cfg, origin_prj, prjs);
+    }
+
+    // Collect the synchronization stamp inputs before we start (so that any
+    // changes made while we are synchronizing are noticed next time) and
+    // invalidate the current stamp in case we fail.
+    //
+    stamp_entries sis (stamp_inputs (prjs));
+    remove_stamp (cfg);
 
     // Verify that no initialized package in any of the projects sharing this
     // configuration is specified as a dependency.
@@ -331,7 +862,10 @@ namespace bdep
     //    like --plan but for progress? Plus there might be no sync at all.
     //
     if (!reps.empty ())
+    {
+      stat_phase sp ("fetch");
       run_bpkg (3, co, "fetch", "-d", cfg, "--shallow", reps);
+    }
 
     string plan ("synchronizing");
     if (name_cfg)
@@ -350,16 +884,19 @@ namespace bdep
     }
     plan += ':';
 
-    run_bpkg (2,
-              co,
-              "build",
-              "-d", cfg,
-              "--no-fetch",
-              "--configure-only",
-              "--keep-out",
-              "--plan", plan,
-              (yes ? "--yes" : nullptr),
-              args);
+    {
+      stat_phase sp ("build");
+      run_bpkg (2,
+                co,
+                "build",
+                "-d", cfg,
+                "--no-fetch",
+                "--configure-only",
+                "--keep-out",
+                "--plan", plan,
+                (yes ? "--yes" : nullptr),
+                args);
+    }
 
     // Handle configuration forwarding.
     //
@@ -466,6 +1003,16 @@ namespace bdep
             // Also note that we try to avoid setting any variables in order
             // not to pollute the configuration's root scope.
             //
+            // Finally, note that we could have had the hook talk to a resident
+            // bdep process (for example, over a local socket) instead of
+            // starting a new one. This, however, would buy us little: the
+            // project databases are opened in the exclusive locking mode
+            // (and so cannot be kept open between requests without blocking
+            // other bdep commands), the bpkg configuration is modified by
+            // bpkg directly, and the synchronization diagnostics and prompts
+            // would have to be proxied back to the build system. So the
+            // better approach is to make the no-op case cheap to detect.
+            //
             os << "# Created automatically by bdep."                   << endl
                << "#"                                                  << endl
                << "if ($build.meta_operation != 'info'      && \\"     << endl
@@ -494,6 +1041,10 @@ namespace bdep
           rm (f);
       }
     }
+
+    add_git_state (sis, prjs);
+    write_stamp (cfg, move (sis));
+    sl.increment ();
   }
 
   // The BDEP_SYNCED_CONFIGS environment variable.
@@ -553,6 +1104,12 @@ namespace bdep
     return false;
   }
 
+  bool
+  cmd_sync_mark (const dir_path& cfg, bool implicit)
+  {
+    return !synced (cfg, implicit);
+  }
+
   void
   cmd_sync (const common_options& co,
             const dir_path& prj,
@@ -561,9 +1118,10 @@ namespace bdep
             bool implicit,
             bool fetch,
             bool yes,
-            bool name_cfg)
+            bool name_cfg,
+            bool marked)
   {
-    if (!synced (c->path, implicit))
+    if (marked || !synced (c->path, implicit))
       cmd_sync (co,
                 c->path,
                 prj,
@@ -579,6 +1137,181 @@ namespace bdep
                 strings ()           /* dep_pkgs  */);
   }
 
+  // Watch the project for changes to the package manifests as well as to
+  // packages.manifest and repositories.manifest and implicitly re-synchronize
+  // its configurations once things settle down (the --watch mode).
+  //
+  // We watch directories rather than files since editors normally save a
+  // file by writing a temporary and renaming it over the original, which
+  // would silently invalidate a watch on the file itself. We also only keep
+  // the project database open while loading the configurations since it is
+  // locked for as long as it is open.
+  //
+  // Note that each round (including the first) synchronizes after the
+  // watches have been established and the synchronization is implicit, that
+  // is, a no-op for configurations with an up-to-date stamp. This way we
+  // don't miss changes made while we were busy synchronizing.
+  //
+#ifdef __linux__
+  static void
+  watch (const cmd_sync_options& o,
+         const dir_path& prj,
+         const optional<string>& synced_env)
+  {
+    tracer trace ("watch");
+
+    auto sys_error = [] ()
+    {
+      return system_error (errno, generic_category ()); // Sanitize.
+    };
+
+    auto manifest = [] (const char* n)
+    {
+      return strcmp (n, "manifest")              == 0 ||
+             strcmp (n, "packages.manifest")     == 0 ||
+             strcmp (n, "repositories.manifest") == 0;
+    };
+
+    // How long to wait for things to settle down after a change (say, a
+    // checkout of a different branch) before synchronizing.
+    //
+    const int settle (300); // Milliseconds.
+
+    if (verb)
+      text << "watching " << prj << " for changes";
+
+    for (uint64_t i (0);; ++i)
+    {
+      // (Re-)establish the watches since packages could have been added or
+      // removed.
+      //
+      auto_fd fd (inotify_init1 (IN_CLOEXEC));
+
+      if (fd.get () == -1)
+        fail << "unable to initialize inotify: " << sys_error ();
+
+      dir_paths ds ({prj});
+      try
+      {
+        for (const package_location& pl: load_packages (prj))
+        {
+          if (!pl.path.empty ())
+            ds.push_back (prj / pl.path);
+        }
+      }
+      catch (const failed&)
+      {
+        // Presumably packages.manifest is being edited. Watch the project
+        // directory and try again once it changes.
+      }
+
+      for (const dir_path& d: ds)
+      {
+        if (inotify_add_watch (fd.get (),
+                               d.string ().c_str (),
+                               IN_CLOSE_WRITE | IN_ATTRIB |
+                               IN_CREATE      | IN_DELETE |
+                               IN_MOVED_TO    | IN_MOVED_FROM) == -1)
+          fail << "unable to watch " << d << ": " << sys_error ();
+      }
+
+      // Synchronize. Note that we keep watching if this fails (diagnostics
+      // has already been issued): the user will presumably fix things up and
+      // this will trigger another round.
+      //
+      try
+      {
+        configurations cfgs;
+        {
+          database db (open (prj, trace));
+
+          transaction t (db.begin ());
+          cfgs = find_configurations (o, prj, t);
+          t.commit ();
+        }
+
+        // Forget the configurations synchronized in the previous round.
+        //
+        if (synced_env)
+          setenv (synced_name, *synced_env);
+        else
+          unsetenv (synced_name);
+
+        for (const shared_ptr<configuration>& c: cfgs)
+        {
+          if (!c->packages.empty ())
+            cmd_sync (o,
+                      prj,
+                      c,
+                      strings () /* pkg_args */,
+                      true       /* implicit */,
+                      true       /* fetch    */,
+                      true       /* yes      */,
+                      true       /* name_cfg */);
+        }
+      }
+      catch (const failed&) {}
+
+      if (o.watch_limit_specified () && i == o.watch_limit ())
+        break;
+
+      // Let the test know that we are ready to wait for changes. Note that
+      // any changes made from now on are queued by inotify.
+      //
+      if (i == 0 && o.watch_ready_specified ())
+      {
+        const strings& c (o.watch_ready ());
+        run (c.front (), strings (c.begin () + 1, c.end ()));
+      }
+
+      // Wait for a manifest to change and then for the changes to settle
+      // down.
+      //
+      for (bool changed (false);;)
+      {
+        pollfd pfd {fd.get (), POLLIN, 0};
+        int r (poll (&pfd, 1, changed ? settle : -1));
+
+        if (r == -1)
+        {
+          if (errno == EINTR)
+            continue;
+
+          fail << "unable to wait for changes: " << sys_error ();
+        }
+
+        if (r == 0)
+          break;
+
+        alignas (inotify_event) char buf[4096];
+        ssize_t n (read (fd.get (), buf, sizeof (buf)));
+
+        if (n == -1)
+        {
+          if (errno == EINTR)
+            continue;
+
+          fail << "unable to read changes: " << sys_error ();
+        }
+
+        for (const char* p (buf); p < buf + n; )
+        {
+          const inotify_event& e (*reinterpret_cast<const inotify_event*> (p));
+
+          if ((e.mask & IN_Q_OVERFLOW) != 0 ||
+              (e.len != 0 && manifest (e.name)))
+          {
+            l4 ([&]{trace << "change " << (e.len != 0 ? e.name : "overflow");});
+            changed = true;
+          }
+
+          p += sizeof (inotify_event) + e.len;
+        }
+      }
+    }
+  }
+#endif
+
   int
   cmd_sync (cmd_sync_options&& o, cli::group_scanner& args)
   {
@@ -631,6 +1364,29 @@ namespace bdep
       o.implicit (true); // Implies --implicit.
     }
 
+    // --watch
+    //
+    if (o.watch ())
+    {
+#ifndef __linux__
+      fail << "--watch is not supported on this platform";
+#endif
+      if (const char* n = (o.implicit () ? "--implicit"   :
+                           o.upgrade ()  ? "--upgrade|-u" :
+                           o.patch ()    ? "--patch|-p"   : nullptr))
+        fail << "--watch specified with " << n;
+
+      if (!dep_pkgs.empty ())
+        fail << "--watch specified with dependency package";
+    }
+
+    // Save the inherited list of synchronized configurations for the
+    // subsequent --watch rounds.
+    //
+    optional<string> synced_env (o.watch ()
+                                 ? getenv (synced_name)
+                                 : optional<string> ());
+
     // --implicit
     //
     if (o.implicit ())
@@ -738,6 +1494,12 @@ namespace bdep
         if (synced (d, o.implicit (), false /* add */))
           continue;
 
+        // Skip configurations that are up to date. Doing it here allows us
+        // to avoid any initialization in the common no-op hook case.
+        //
+        if (pkg_args.empty () && check_stamp (d))
+          continue;
+
         cfgs.push_back (nullptr);
         cfg_dirs.push_back (move (d));
       }
@@ -752,6 +1514,25 @@ namespace bdep
 
     // Synchronize each configuration.
     //
+    bool fetch (o.fetch () || o.fetch_full ());
+
+    // If synchronizing multiple configurations, then fetch in all of them
+    // upfront and, if requested, in parallel (see cmd_fetch() for details).
+    //
+    if (fetch && cfgs.size () > 1)
+    {
+      configurations fcs;
+      for (const shared_ptr<configuration>& c: cfgs)
+      {
+        if (c != nullptr           &&
+            !c->packages.empty () &&
+            !synced (c->path, o.implicit (), false /* add */))
+          fcs.push_back (c);
+      }
+
+      cmd_fetch (o, prj, fcs, o.fetch_full ());
+    }
+
     for (size_t i (0), n (cfgs.size ()); i != n; ++i)
     {
       const shared_ptr<configuration>& c (cfgs[i]); // Can be NULL.
@@ -779,9 +1560,7 @@ namespace bdep
         text << (i == 0 ? "" : "\n")
              << "in configuration " << *c << ':';
 
-      bool fetch (o.fetch () || o.fetch_full ());
-
-      if (fetch)
+      if (fetch && n == 1)
         cmd_fetch (o, prj, c, o.fetch_full ());
 
       if (!dep_pkgs.empty ())
@@ -847,6 +1626,11 @@ namespace bdep
       }
     }
 
+#ifdef __linux__
+    if (o.watch ())
+      watch (o, prj, synced_env);
+#endif
+
     return 0;
   }
 }
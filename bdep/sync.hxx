@@ -19,7 +19,8 @@ namespace bdep
   // If fetch is false, don't perform a (shallow) fetch of the project
   // repository. If yes is false, then don't suppress bpkg prompts. If
   // name_cfg is true then include the configuration name/directory into
-  // progress.
+  // progress. If marked is true, then assume the configuration has already
+  // been marked as being synchronized with cmd_sync_mark().
   //
   void
   cmd_sync (const common_options&,
@@ -29,21 +30,39 @@ namespace bdep
             bool implicit,
             bool fetch = true,
             bool yes = true,
-            bool name_cfg = false);
+            bool name_cfg = false,
+            bool marked = false);
+
+  // Mark the configuration as being synchronized by the current bdep
+  // invocation chain (see BDEP_SYNCED_CONFIGS) and return true or, if it is
+  // already (being) synchronized, return false in the implicit mode and fail
+  // otherwise.
+  //
+  // This is normally used to synchronize several configurations in parallel
+  // since the marking modifies the environment and so must be done before
+  // starting any threads that may execute processes.
+  //
+  bool
+  cmd_sync_mark (const dir_path& cfg, bool implicit);
 
   int
   cmd_sync (cmd_sync_options&&, cli::group_scanner& args);
 
 
   // Return the list of additional (to prj, if not empty) projects that are
-  // using this configuration.
+  // using this configuration. If existing is false, then also include the
+  // project directories that no longer exist (for example, the old location
+  // of a moved project).
   //
   dir_paths
   configuration_projects (const common_options& co,
                           const dir_path& cfg,
-                          const dir_path& prj = dir_path ());
+                          const dir_path& prj = dir_path (),
+                          bool existing = true);
 
-  extern const path hook_file; // build/bootstrap/pre-bdep-sync.build
+  extern const path hook_file;  // build/bootstrap/pre-bdep-sync.build
+  extern const path stamp_file; // build/bootstrap/bdep-sync.stamp
+  extern const path lock_file;  // build/bootstrap/bdep-sync.lock
 }
 
 #endif // BDEP_SYNC_HXX
@@ -0,0 +1,551 @@
+// file      : bdep/test.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <bdep/test.hxx>
+
+#include <libbutl/sha256.mxx>
+
+#include <bdep/git.hxx>
+#include <bdep/project.hxx>
+#include <bdep/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace bdep
+{
+  // Run git with the specified arguments in the project directory and
+  // append each NUL-terminated entry of its output to the result. Note that
+  // the arguments should include -z since otherwise git quotes the paths
+  // with unusual characters (see core.quotePath for details).
+  //
+  template <typename... A>
+  static void
+  git_entries (const dir_path& prj, strings& r, A&&... args)
+  {
+    fdpipe pipe (open_pipe ()); // Text mode seems appropriate.
+
+    process pr (start_git (semantic_version {2, 1, 0},
+                           prj,
+                           0    /* stdin  */,
+                           pipe /* stdout */,
+                           2    /* stderr */,
+                           forward<A> (args)...));
+
+    // Shouldn't throw, unless something is severely damaged.
+    //
+    pipe.out.close ();
+
+    bool io (false);
+    try
+    {
+      ifdstream is (move (pipe.in), fdstream_mode::skip, ifdstream::badbit);
+
+      for (string l; !eof (getline (is, l, '\0')); )
+        r.push_back (move (l));
+
+      is.close (); // Detect errors.
+    }
+    catch (const io_error&)
+    {
+      // Presumably the child process failed so let finish_git() deal with
+      // that first.
+      //
+      io = true;
+    }
+
+    finish_git (pr, io);
+  }
+
+  // Return the index of the package with the longest directory that
+  // contains the specified file (relative to the project directory) or
+  // pls.size () if there is no such package.
+  //
+  static size_t
+  find_package (const package_locations& pls, const path& f)
+  {
+    size_t r (pls.size ());
+
+    for (size_t i (0); i != pls.size (); ++i)
+    {
+      const dir_path& d (pls[i].path);
+
+      if ((d.empty () || f.sub (d)) &&
+          (r == pls.size () || d.size () > pls[r].path.size ()))
+        r = i;
+    }
+
+    return r;
+  }
+
+  // Return the project packages affected by the changes since the specified
+  // revision.
+  //
+  static package_names
+  changed_packages (const dir_path& prj, const string& rev)
+  {
+    tracer trace ("changed_packages");
+
+    if (!git_repository (prj))
+      fail << "project " << prj << " is not a git repository" <<
+        info << "--changed-since requires git";
+
+    // Note that the paths are relative to the project directory (which may
+    // be a subdirectory of the repository).
+    //
+    strings fs;
+    git_entries (prj, fs,
+                 "diff", "-z", "--name-only", "--relative", rev, "--");
+    git_entries (prj, fs, "ls-files", "-z", "--others", "--exclude-standard");
+
+    package_graph g (load_package_graph (prj));
+    const package_locations& pls (g.packages);
+
+    vector<size_t> ps;
+    for (const string& s: fs)
+    {
+      path f;
+      try
+      {
+        f = path (s);
+      }
+      catch (const invalid_path&)
+      {
+        fail << "invalid path '" << s << "' in git output";
+      }
+
+      size_t p (find_package (pls, f));
+
+      // A file outside of any package affects all of them.
+      //
+      if (p == pls.size ())
+      {
+        l4 ([&]{trace << s << " is outside of any package";});
+
+        ps.clear ();
+        for (size_t i (0); i != pls.size (); ++i)
+          ps.push_back (i);
+
+        break;
+      }
+
+      if (find (ps.begin (), ps.end (), p) == ps.end ())
+        ps.push_back (p);
+    }
+
+    package_names r;
+    for (size_t i: g.dependents (ps))
+      r.push_back (pls[i].name);
+
+    return r;
+  }
+
+  // Test result cache.
+  //
+  // For each package that has passed its tests we save a key that is the
+  // checksum of everything that can affect the result: the package source
+  // files (the git object ids, if possible, and the file contents
+  // otherwise), the keys of the project packages it depends on, the
+  // configuration's config.build, and the test command line. Then, on the
+  // next run, we skip packages whose keys haven't changed.
+  //
+  // The cache is stored in the configuration (and so shared by all the
+  // projects that use it) and has the following format:
+  //
+  // <key> <package>
+  //
+  const path test_cache_file (
+    dir_path ("build") / "bootstrap" / "bdep-test.cache");
+
+  // Append the file contents to the checksum.
+  //
+  static void
+  append_file (sha256& cs, const path& f)
+  {
+    try
+    {
+      ifdstream is (f, fdopen_mode::binary, ifdstream::badbit);
+
+      char buf[8192];
+      while (!is.eof ())
+      {
+        is.read (buf, sizeof (buf));
+        cs.append (buf, static_cast<size_t> (is.gcount ()));
+      }
+
+      is.close ();
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to read " << f << ": " << e;
+    }
+  }
+
+  // Calculate the source checksum of each project package using git, if
+  // possible, and by reading all the files otherwise.
+  //
+  static strings
+  source_checksums (const dir_path& prj, const package_locations& pls)
+  {
+    vector<sha256> css (pls.size ());
+
+    if (git_repository (prj))
+    {
+      // Note that the index object ids do not reflect the uncommitted
+      // changes in the working tree so for modified and untracked files we
+      // additionally hash their contents.
+      //
+      strings ls;
+      git_entries (prj, ls, "ls-files", "-z", "--stage");
+
+      for (const string& l: ls)
+      {
+        // <mode> <object> <stage>\t<file>
+        //
+        size_t p (l.find ('\t'));
+        if (p == string::npos)
+          fail << "invalid git ls-files output entry '" << l << "'";
+
+        size_t i (find_package (pls, path (string (l, p + 1))));
+        if (i != pls.size ())
+          css[i].append (l);
+      }
+
+      strings fs;
+      git_entries (prj, fs, "ls-files", "-z", "--modified");
+      git_entries (prj, fs,
+                   "ls-files", "-z", "--others", "--exclude-standard");
+
+      for (const string& s: fs)
+      {
+        path f (s);
+        size_t i (find_package (pls, f));
+
+        if (i == pls.size ())
+          continue;
+
+        css[i].append (s);
+
+        // Note that deleted files are also listed as modified.
+        //
+        f = prj / f;
+        if (exists (f))
+          append_file (css[i], f);
+      }
+    }
+    else
+    {
+      // Skip symlinks (which is how the build system normally backlinks
+      // the forwarded configuration output into the source directory) as
+      // well as the forwarded configuration's out-root.build.
+      //
+      const path orb (dir_path ("build") / "bootstrap" / "out-root.build");
+
+      for (size_t i (0); i != pls.size (); ++i)
+      {
+        dir_path pd (prj / pls[i].path);
+
+        function<void (const dir_path&)> walk (
+          [&css, &pd, &orb, &walk, i] (const dir_path& d)
+          {
+            try
+            {
+              for (const dir_entry& e:
+                     dir_iterator (pd / d, true /* ignore_dangling */))
+              {
+                path f (d / e.path ());
+
+                switch (e.ltype ())
+                {
+                case entry_type::directory:
+                  {
+                    walk (path_cast<dir_path> (move (f)));
+                    break;
+                  }
+                case entry_type::regular:
+                  {
+                    if (f != orb)
+                    {
+                      css[i].append (f.string ());
+                      append_file (css[i], pd / f);
+                    }
+                    break;
+                  }
+                default: break;
+                }
+              }
+            }
+            catch (const system_error& e)
+            {
+              fail << "unable to iterate over " << pd / d << ": " << e;
+            }
+          });
+
+        walk (dir_path ());
+      }
+    }
+
+    strings r;
+    for (sha256& cs: css)
+      r.push_back (cs.string ());
+
+    return r;
+  }
+
+  // Project information that is used to calculate the cache keys. Since it
+  // does not depend on the configuration, it is only calculated once, when
+  // testing in the first configuration, rather than for each configuration.
+  //
+  namespace
+  {
+    struct cache_project
+    {
+      package_graph graph;
+      strings       sources; // Source checksum of each package.
+    };
+  }
+
+  static optional<cache_project> cache_prj;
+
+  static const cache_project&
+  load_cache_project (const cmd_test_options& o)
+  {
+    if (!cache_prj)
+    {
+      dir_path prj (find_project (o));
+      package_graph g (load_package_graph (prj));
+      strings srcs (source_checksums (prj, g.packages));
+
+      cache_prj = cache_project {move (g), move (srcs)};
+    }
+
+    return *cache_prj;
+  }
+
+  // Calculate the cache key of each project package.
+  //
+  static strings
+  cache_keys (const cmd_test_options& o,
+              const dir_path& cfg,
+              const strings& cfg_vars,
+              const cache_project& p)
+  {
+    const package_graph& g (p.graph);
+
+    // Things that affect all the packages.
+    //
+    sha256 cs;
+    {
+      path f (cfg / "build" / "config.build");
+      if (exists (f))
+        append_file (cs, f);
+
+      for (const string& v: cfg_vars)
+        cs.append (v);
+
+      cs.append (o.immediate () ? "immediate" :
+                 o.recursive () ? "recursive" : "");
+    }
+    string common (cs.string ());
+
+    const strings& srcs (p.sources);
+    strings r (g.packages.size ());
+
+    // Note that the dependencies are always in the earlier waves.
+    //
+    for (const vector<size_t>& w: g.waves ())
+    {
+      for (size_t i: w)
+      {
+        sha256 cs;
+        cs.append (common);
+        cs.append (srcs[i]);
+
+        for (size_t d: g.dependencies[i])
+          cs.append (r[d]);
+
+        r[i] = cs.string ();
+      }
+    }
+
+    return r;
+  }
+
+  static map<string, string>
+  load_cache (const dir_path& cfg)
+  {
+    map<string, string> r;
+
+    path f (cfg / test_cache_file);
+    if (!exists (f))
+      return r;
+
+    try
+    {
+      ifdstream is (f, ifdstream::badbit);
+
+      for (string l; !eof (getline (is, l)); )
+      {
+        if (l.empty () || l[0] == '#')
+          continue;
+
+        size_t p (l.find (' '));
+        if (p == string::npos || p + 1 == l.size ())
+          return map<string, string> (); // Corrupted, ignore.
+
+        r[string (l, p + 1)] = string (l, 0, p);
+      }
+
+      is.close ();
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to read " << f << ": " << e;
+    }
+
+    return r;
+  }
+
+  static void
+  save_cache (const dir_path& cfg, const map<string, string>& m)
+  {
+    path f (cfg / test_cache_file);
+
+    try
+    {
+      dir_path d (f.directory ());
+      if (!exists (d))
+        mk (d);
+
+      ofdstream os (f);
+
+      os << "# Created automatically by bdep." << endl;
+
+      for (const auto& p: m)
+        os << p.second << ' ' << p.first << endl;
+
+      os.close ();
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to write " << f << ": " << e;
+    }
+  }
+
+  static void
+  run_test (const cmd_test_options& o,
+            const shared_ptr<configuration>& c,
+            const cstrings& pkgs,
+            const strings& cfg_vars)
+  {
+    run_bpkg (2,
+              o,
+              (o.jobs_specified ()
+               ? strings ({"-j", to_string (o.jobs ())})
+               : strings ()),
+              "test",
+              "-d", c->path,
+              (o.immediate () ? "--immediate" :
+               o.recursive () ? "--recursive" : nullptr),
+              cfg_vars,
+              pkgs);
+  }
+
+  void
+  cmd_test (const cmd_test_options& o,
+            const shared_ptr<configuration>& c,
+            const cstrings& pkgs,
+            const strings& cfg_vars)
+  {
+    if (!o.cache ())
+    {
+      run_test (o, c, pkgs, cfg_vars);
+      return;
+    }
+
+    const dir_path& cfg (c->path);
+
+    const cache_project& p (load_cache_project (o));
+    const package_graph& g (p.graph);
+    strings keys (cache_keys (o, cfg, cfg_vars, p));
+
+    map<string, string> cache (load_cache (cfg));
+
+    // Weed out the packages with matching keys.
+    //
+    cstrings ps;
+    vector<pair<string, string>> ks; // Keys of the packages being tested.
+
+    for (const char* n: pkgs)
+    {
+      // Packages other than of this project (e.g., dependencies specified
+      // on the command line) are always tested.
+      //
+      size_t i (g.find (package_name (n)));
+      if (i == g.packages.size ())
+      {
+        ps.push_back (n);
+        continue;
+      }
+
+      auto j (cache.find (n));
+      if (j != cache.end () && j->second == keys[i])
+      {
+        if (verb)
+          info << "skipping package " << n << ": test result is cached";
+
+        continue;
+      }
+
+      ps.push_back (n);
+      ks.emplace_back (n, keys[i]);
+    }
+
+    if (ps.empty ())
+      return;
+
+    // Note that we only save the keys if all the tests have passed since we
+    // cannot tell which ones have failed otherwise.
+    //
+    run_test (o, c, ps, cfg_vars);
+
+    for (pair<string, string>& k: ks)
+      cache[move (k.first)] = move (k.second);
+
+    save_cache (cfg, cache);
+  }
+
+  int
+  cmd_test (const cmd_test_options& o, cli::scanner& args)
+  {
+    if (o.immediate () && o.recursive ())
+      fail << "both --immediate|-i and --recursive|-r specified";
+
+    package_filter pf;
+
+    if (o.changed_since_specified ())
+    {
+      const string& rev (o.changed_since ());
+
+      pf = [&rev] (const dir_path& prj)
+      {
+        package_names ps (changed_packages (prj, rev));
+
+        if (verb >= 2)
+        {
+          for (const package_name& n: ps)
+            text << "package " << n << " is affected by changes since "
+                 << rev;
+        }
+
+        return [ps = move (ps)] (const package_name& n)
+        {
+          return find (ps.begin (), ps.end (), n) != ps.end ();
+        };
+      };
+    }
+
+    return cmd_build (o, &cmd_test, args, pf);
+  }
+}
@@ -13,33 +13,19 @@
 
 namespace bdep
 {
-  inline void
-  cmd_test (const cmd_test_options& o,
-            const shared_ptr<configuration>& c,
+  // Test the packages in the configuration skipping those whose test
+  // results are cached, if requested (see --cache for details).
+  //
+  void
+  cmd_test (const cmd_test_options&,
+            const shared_ptr<configuration>&,
             const cstrings& pkgs,
-            const strings& cfg_vars)
-  {
-    run_bpkg (2,
-              o,
-              (o.jobs_specified ()
-               ? strings ({"-j", to_string (o.jobs ())})
-               : strings ()),
-              "test",
-              "-d", c->path,
-              (o.immediate () ? "--immediate" :
-               o.recursive () ? "--recursive" : nullptr),
-              cfg_vars,
-              pkgs);
-  }
+            const strings& cfg_vars);
 
-  inline int
-  cmd_test (const cmd_test_options& o, cli::scanner& args)
-  {
-    if (o.immediate () && o.recursive ())
-      fail << "both --immediate|-i and --recursive|-r specified";
+  int
+  cmd_test (const cmd_test_options&, cli::scanner& args);
 
-    return cmd_build (o, &cmd_test, args);
-  }
+  extern const path test_cache_file; // build/bootstrap/bdep-test.cache
 }
 
 #endif // BDEP_TEST_HXX
@@ -2,8 +2,22 @@
 // copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
 // license   : MIT; see accompanying LICENSE file
 
+#ifndef _WIN32
+#  include <poll.h>     // poll()
+#  include <fcntl.h>    // open(), fcntl()
+#  include <unistd.h>   // read(), write(), close()
+#  include <sys/stat.h> // fstat()
+#endif
+
+#include <cerrno>
+
 #include <bdep/utility.hxx>
 
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <exception> // exception_ptr
+
 #include <libbutl/process.mxx>
 #include <libbutl/fdstream.mxx>
 
@@ -202,6 +216,276 @@ namespace bdep
     }
   }
 
+  size_t
+  parallel_jobs (const common_options& co, size_t def)
+  {
+    size_t r (co.jobs_specified () ? co.jobs () : def);
+
+    if (r == 0)
+    {
+      r = thread::hardware_concurrency ();
+
+      if (r == 0) // Unknown.
+        r = 1;
+    }
+
+    return r;
+  }
+
+  // GNU make jobserver client.
+  //
+  // If we are executed by make as part of a recursive invocation, then
+  // MAKEFLAGS contains the jobserver description that is either a pair of
+  // pipe file descriptors (--jobserver-auth=R,W or, for make before 4.2,
+  // --jobserver-fds=R,W) or, since make 4.4, a named pipe
+  // (--jobserver-auth=fifo:PATH). Each job except the first one (which we
+  // have implicitly) must then acquire a token by reading a byte from the
+  // pipe and release it by writing the byte back once done.
+  //
+  // Note that we only act as a client, limiting the number of calls that
+  // parallel_for() performs concurrently: the build system and the package
+  // manager that we execute do not participate in the jobserver protocol
+  // and so there is nothing to serve them with.
+  //
+  // Note also that make (since 4.2) keeps the descriptors in MAKEFLAGS even
+  // if it closes them for the commands it does not consider recursive make
+  // invocations (those not marked with '+'). Such descriptors can then be
+  // reused for our own files (database, trace file, etc) and reading or
+  // writing a token would corrupt them. That's why we set things up on
+  // startup before opening anything (see jobserver_init()), only accept the
+  // descriptors that refer to pipes, and use their duplicates.
+  //
+#ifndef _WIN32
+  struct jobserver
+  {
+    int in  = -1;
+    int out = -1;
+
+    explicit
+    operator bool () const {return in != -1;}
+
+    void
+    init ()
+    {
+      optional<string> mf (getenv ("MAKEFLAGS"));
+      if (!mf)
+        return;
+
+      // Note that the last occurrence of the option takes precedence.
+      //
+      size_t p (mf->rfind ("--jobserver-auth="));
+      if (p != string::npos)
+        p += 17;
+      else if ((p = mf->rfind ("--jobserver-fds=")) != string::npos)
+        p += 16;
+      else
+        return;
+
+      string v (*mf, p, mf->find (' ', p) - p);
+
+      auto fifo = [] (int fd)
+      {
+        struct stat s;
+        return fd >= 0 && fstat (fd, &s) == 0 && S_ISFIFO (s.st_mode);
+      };
+
+      // Open the named pipe in the non-blocking mode so that read() fails
+      // with EAGAIN rather than blocks if another process grabs the token
+      // after we have polled (see acquire() for details).
+      //
+      if (v.compare (0, 5, "fifo:") == 0)
+      {
+        int fd (open (v.c_str () + 5, O_RDWR | O_NONBLOCK | O_CLOEXEC));
+
+        if (fifo (fd))
+          in = out = fd;
+        else if (fd != -1)
+          close (fd);
+      }
+      else
+      {
+        size_t c (v.find (','));
+        if (c == string::npos)
+          return;
+
+        int r, w;
+        try
+        {
+          r = stoi (string (v, 0, c));
+          w = stoi (string (v, c + 1));
+        }
+        catch (const logic_error&)
+        {
+          return;
+        }
+
+        // Make only passes the descriptors to the commands it considers
+        // recursive make invocations (those marked with '+'), so they may
+        // well be closed (see above). Also duplicate them so that they are
+        // not inherited by the programs we execute.
+        //
+        if (fifo (r) && fifo (w))
+        {
+          int i (fcntl (r, F_DUPFD_CLOEXEC, 0));
+          int o (i != -1 ? fcntl (w, F_DUPFD_CLOEXEC, 0) : -1);
+
+          if (o != -1)
+          {
+            in  = i;
+            out = o;
+          }
+          else if (i != -1)
+            close (i);
+        }
+      }
+    }
+
+    // Acquire a token returning absent value if stop was requested in the
+    // meantime. If the jobserver is unusable, then proceed without a token,
+    // returning the '\0' value (which should not be released). Note that we
+    // poll with a timeout in order to notice the stop request.
+    //
+    // Note also that some other process may grab the token between poll()
+    // and read(). For the named pipe this is handled by opening it in the
+    // non-blocking mode. The inherited pipe descriptors, however, share the
+    // open file description with make and other clients and so we cannot
+    // change its mode. In this case read() may still block until some token
+    // is released.
+    //
+    optional<char>
+    acquire (const atomic<bool>& stop) const
+    {
+      for (char t;;)
+      {
+        if (stop)
+          return nullopt;
+
+        pollfd pfd {in, POLLIN, 0};
+        int r (poll (&pfd, 1, 100 /* ms */));
+
+        if (r == 0 || (r == -1 && errno == EINTR))
+          continue;
+
+        if (r == -1)
+          return '\0';
+
+        ssize_t n (read (in, &t, 1));
+
+        if (n == 1)
+          return t;
+
+        if (n == 0 || (errno != EINTR && errno != EAGAIN))
+          return '\0';
+      }
+    }
+
+    void
+    release (char t) const
+    {
+      if (t != '\0')
+        while (write (out, &t, 1) == -1 && errno == EINTR) ;
+    }
+  };
+
+  static jobserver js;
+#endif
+
+  void
+  jobserver_init ()
+  {
+#ifndef _WIN32
+    js.init ();
+#endif
+  }
+
+  void
+  parallel_for (size_t n, size_t jobs, const function<void (size_t)>& f)
+  {
+    if (jobs > n)
+      jobs = n;
+
+    if (jobs <= 1)
+    {
+      for (size_t i (0); i != n; ++i)
+        f (i);
+
+      return;
+    }
+
+    atomic<size_t> next (0);
+    atomic<bool>   stop (false);
+
+    mutex m;
+    size_t        ei (n); // Index of the first failed call.
+    exception_ptr ep;
+
+    // Note that the current thread has the implicit jobserver token.
+    //
+    auto work = [n, &f, &next, &stop, &m, &ei, &ep] (bool token)
+    {
+      for (size_t i; !stop && next < n; )
+      {
+#ifndef _WIN32
+        optional<char> t;
+        if (!token && js && !(t = js.acquire (stop)))
+          break;
+
+        auto g (
+          make_guard (
+            [&t] ()
+            {
+              if (t)
+                js.release (*t);
+            }));
+#else
+        (void) token;
+#endif
+
+        if ((i = next++) >= n)
+          break;
+
+        try
+        {
+          f (i);
+        }
+        catch (...)
+        {
+          stop = true;
+
+          lock_guard<mutex> l (m);
+
+          if (i < ei)
+          {
+            ei = i;
+            ep = current_exception ();
+          }
+        }
+      }
+    };
+
+    vector<thread> ts;
+    ts.reserve (jobs - 1);
+
+    try
+    {
+      for (size_t i (1); i != jobs; ++i)
+        ts.emplace_back (work, false /* token */);
+    }
+    catch (const system_error&)
+    {
+      // Carry on with the threads we have managed to start, if any (the
+      // current thread will process the rest).
+    }
+
+    work (true /* token */);
+
+    for (thread& t: ts)
+      t.join ();
+
+    if (ep != nullptr)
+      rethrow_exception (ep);
+  }
+
   const char*
   name_bpkg (const common_options& co)
   {
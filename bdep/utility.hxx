@@ -210,6 +210,38 @@ namespace bdep
   void
   run_b (const common_options&, A&&... args);
 
+  // Parallel execution.
+  //
+  // Return the number of jobs to use for performing independent tasks (for
+  // example, processing build configurations) in parallel. If --jobs is not
+  // specified, then return the specified default. In both cases 0 means the
+  // number of available hardware threads.
+  //
+  size_t
+  parallel_jobs (const common_options&, size_t def = 0);
+
+  // Call the specified function for each index in the [0, n) range using up
+  // to the specified number of threads. If the number of jobs is 1, then
+  // perform the calls serially in the current thread. Otherwise, if running
+  // under the GNU make jobserver, then the calls in the additional threads
+  // are only performed after acquiring a jobserver token.
+  //
+  // If any call throws, then stop starting new calls, wait for the already
+  // started ones to complete, and rethrow the exception of the failed call
+  // with the smallest index. Note that the calls that issue diagnostics
+  // should make sure it is complete (for example, by using the diag_record
+  // API) since the diagnostics of concurrent calls may interleave.
+  //
+  void
+  parallel_for (size_t n, size_t jobs, const function<void (size_t)>&);
+
+  // Set up the GNU make jobserver client used by parallel_for(), if running
+  // under the jobserver. Must be called on startup before opening any files
+  // (see the implementation for details).
+  //
+  void
+  jobserver_init ();
+
   // Manifest parsing and serialization.
   //
   // For parsing, if path is '-', then read from stdin.
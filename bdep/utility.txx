@@ -5,6 +5,7 @@
 #include <cstring>  // strcmp()
 #include <iostream> // cin
 
+#include <bdep/stat.hxx>
 #include <bdep/diagnostics.hxx>
 
 namespace bdep
@@ -15,9 +16,13 @@ namespace bdep
   {
     try
     {
-      return butl::process_start_callback (
-        [] (const char* const args[], size_t n)
+      stat_command sc; // For --stat and --trace-file.
+
+      process pr (butl::process_start_callback (
+        [&sc] (const char* const args[], size_t n)
         {
+          sc.assign (args, n);
+
           if (verb >= 2)
             print_process (args, n);
         },
@@ -25,7 +30,10 @@ namespace bdep
         forward<O> (out),
         forward<E> (err),
         prog,
-        forward<A> (args)...);
+        forward<A> (args)...));
+
+      stat_start (pr, move (sc));
+      return pr;
     }
     catch (const process_error& e)
     {
@@ -37,7 +45,7 @@ namespace bdep
   void
   finish (const P& prog, process& pr, bool io_read, bool io_write)
   {
-    if (!pr.wait ())
+    if (!stat_wait (pr))
     {
       const process_exit& e (*pr.exit);
 
@@ -133,9 +141,13 @@ namespace bdep
         ops.push_back (o.c_str ());
       }
 
-      return process_start_callback (
-        [v] (const char* const args[], size_t n)
+      stat_command sc;
+
+      process pr (process_start_callback (
+        [v, &sc] (const char* const args[], size_t n)
         {
+          sc.assign (args, n);
+
           if (verb >= v)
             print_process (args, n);
         },
@@ -145,7 +157,10 @@ namespace bdep
         pp,
         ops,
         co.bpkg_option (),
-        forward<A> (args)...);
+        forward<A> (args)...));
+
+      stat_start (pr, move (sc));
+      return pr;
     }
     catch (const process_error& e)
     {
@@ -217,9 +232,13 @@ namespace bdep
           ops.push_back ("--no-progress");
       }
 
-      return process_start_callback (
-        [v] (const char* const args[], size_t n)
+      stat_command sc;
+
+      process pr (process_start_callback (
+        [v, &sc] (const char* const args[], size_t n)
         {
+          sc.assign (args, n);
+
           if (verb >= v)
             print_process (args, n);
         },
@@ -229,7 +248,10 @@ namespace bdep
         pp,
         ops,
         co.build_option (),
-        forward<A> (args)...);
+        forward<A> (args)...));
+
+      stat_start (pr, move (sc));
+      return pr;
     }
     catch (const process_error& e)
     {
@@ -267,6 +289,8 @@ namespace bdep
       if (!file_exists (f))
         fail << what << " manifest file " << f << " does not exist";
 
+      stat_phase sp ("manifest load");
+
       ifdstream ifs (f);
       return parse_manifest<T> (ifs, f.string (), what, iu, move (ff));
     }
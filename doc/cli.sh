@@ -63,7 +63,7 @@ compile "common" $o --output-suffix "-options" --class-doc bdep::common_options=
 compile "bdep" $o --output-prefix "" --class-doc bdep::commands=short --class-doc bdep::topics=short
 
 pages="new help init sync fetch status ci release publish deinit config test \
-update clean projects-configs"
+update clean foreach projects-configs"
 
 for p in $pages; do
   compile $p $o
@@ -0,0 +1,239 @@
+#! /usr/bin/env bash
+
+# Benchmark the bdep scalability: generate a project with N packages and M
+# build configurations and measure the wall time and the number of child
+# processes executed by init, sync, status, update, and deinit.
+#
+# Usage: bench.sh [<options>] [-- <cfg-args>]
+#
+# -n <num>
+#    Number of packages, 10 by default.
+#
+# -m <num>
+#    Number of build configurations, 2 by default.
+#
+# -t <type>
+#    Package type (see bdep-new(1)), bare by default. Note that with the bare
+#    packages update only measures the build system overhead.
+#
+# --bdep <path>
+#    The bdep executable to benchmark, bdep from PATH by default.
+#
+# --work <dir>
+#    Work directory. If unspecified, then a temporary directory is used and
+#    removed on exit.
+#
+# --json
+#    Print the results as JSON objects, one per line, rather than TSV.
+#
+# The <cfg-args> are passed to bpkg-cfg-create(1) for each configuration,
+# cc by default.
+#
+# The results are printed to stdout, one line per measured command, with
+# the following fields:
+#
+# command packages configurations seconds processes version
+#
+# The commands are:
+#
+# init           bdep init -C of all the packages in each configuration
+# sync           explicit sync with nothing to synchronize
+# sync-implicit  implicit (build system hook) sync with nothing to sync
+# sync-change    explicit sync after a package manifest change
+# status         status of all the packages in all the configurations
+# update         update of all the packages in all the configurations
+# deinit         deinit of all the packages from all the configurations
+#
+# The processes count is obtained from the --trace-file timeline and
+# includes the processes executed by the nested bdep invocations (for
+# example, by the build system hook). Diagnostics is written to bench.log in
+# the work directory.
+#
+# For example:
+#
+# $ bench.sh -n 1000 -m 20 -- cc config.cxx=clang++ >>results.tsv
+#
+trap 'exit 1' ERR
+set -o errtrace # Trap in functions.
+
+function info () { echo "$*" 1>&2; }
+function error () { info "$*"; exit 1; }
+
+n=10
+m=2
+type=bare
+bdep=bdep
+work=
+json=
+
+while [ $# -gt 0 ]; do
+  case $1 in
+    -n)
+      shift
+      n="$1"
+      shift
+      ;;
+    -m)
+      shift
+      m="$1"
+      shift
+      ;;
+    -t)
+      shift
+      type="$1"
+      shift
+      ;;
+    --bdep)
+      shift
+      bdep="$1"
+      shift
+      ;;
+    --work)
+      shift
+      work="$1"
+      shift
+      ;;
+    --json)
+      json=true
+      shift
+      ;;
+    --)
+      shift
+      break
+      ;;
+    *)
+      error "unexpected $1"
+      ;;
+  esac
+done
+
+if [ -z "$n" -o -z "$m" -o -z "$type" -o -z "$bdep" ]; then
+  error "missing option value"
+fi
+
+# Use a bash array to handle empty arguments.
+#
+cfg_args=()
+while [ $# -gt 0 ]; do
+  cfg_args=("${cfg_args[@]}" "$1")
+  shift
+done
+
+if [ "${#cfg_args[@]}" -eq 0 ]; then
+  cfg_args=(cc)
+fi
+
+if [ -z "$work" ]; then
+  work="$(mktemp -d -t bdep-bench.XXXXXXXX)"
+  trap "rm -rf '$work'" EXIT
+else
+  mkdir -p "$work"
+  work="$(cd "$work" && pwd)"
+
+  if [ -e "$work/prj" ]; then
+    error "$work is not empty"
+  fi
+fi
+
+cd "$work"
+
+version="$("$bdep" --version | sed -n -e 's/^bdep \(.*\)$/\1/p')"
+log="$work/bench.log"
+
+function now ()
+{
+  if [ -n "$EPOCHREALTIME" ]; then
+    echo "$EPOCHREALTIME"
+  else
+    date +%s.%N
+  fi
+}
+
+# Accumulated wall time and process count for each command.
+#
+declare -A seconds
+declare -A processes
+
+# Run bdep with the specified arguments adding the wall time and the number
+# of processes to the command's totals.
+#
+function measure () # <command> <bdep-args>...
+{
+  local c="$1"
+  shift
+
+  local t="$work/$c.trace"
+  local s e p
+
+  s="$(now)"
+  "$bdep" "$@" --trace-file "$t" >>"$log" 2>&1 || error "$c failed, see $log"
+  e="$(now)"
+
+  # Note that grep -c exits with 1 if there are no matches.
+  #
+  p="$(grep -c '"cat":"process"' "$t" || true)"
+
+  seconds[$c]="$(awk -v s="$s" -v e="$e" -v a="${seconds[$c]:-0}" \
+'BEGIN {printf "%.3f", a + e - s}')"
+  processes[$c]="$(( ${processes[$c]:-0} + p ))"
+}
+
+function result () # <command>
+{
+  local c="$1"
+
+  if [ "$json" ]; then
+    echo "{\"command\":\"$c\",\"packages\":$n,\"configurations\":$m,\
+\"seconds\":${seconds[$c]},\"processes\":${processes[$c]},\
+\"version\":\"$version\"}"
+  else
+    printf '%s\t%s\t%s\t%s\t%s\t%s\n' \
+"$c" "$n" "$m" "${seconds[$c]}" "${processes[$c]}" "$version"
+  fi
+}
+
+# Generate the project (not measured).
+#
+info "generating $n packages in $work/prj"
+
+"$bdep" new --no-init -t empty prj >>"$log" 2>&1 || error "new failed"
+
+for i in $(seq 1 "$n"); do
+  echo "pkg$i"
+done >packages.batch
+
+"$bdep" new --batch packages.batch --package -t "$type" -d prj >>"$log" 2>&1 \
+  || error "new --batch failed"
+
+# Measure.
+#
+info "measuring with $m configurations"
+
+for j in $(seq 1 "$m"); do
+  measure init init -d prj -C "cfg$j" "@cfg$j" "${cfg_args[@]}"
+done
+
+measure sync sync --all -d prj
+
+# Note that this is what the build system hook executes for each
+# configuration.
+#
+for j in $(seq 1 "$m"); do
+  measure sync-implicit sync --implicit -c "$work/cfg$j"
+done
+
+echo 'tags: bench' >>prj/pkg1/manifest
+measure sync-change sync --all -d prj
+
+measure status status --all -d prj
+measure update update --all -d prj
+measure deinit deinit --all -d prj
+
+if [ ! "$json" ]; then
+  printf '# %s\t%s\t%s\t%s\t%s\t%s\n' \
+command packages configurations seconds processes version
+fi
+
+for c in init sync sync-implicit sync-change status update deinit; do
+  result "$c"
+done